@@ -0,0 +1,110 @@
+// Checks that the bitboard evaluation kernels score every position exactly
+// like the original square-by-square scans, and that the accumulator the
+// search updates move by move stays equal to a full recompute. Like the
+// microbench it compiles the engine sources itself, since the kernels are
+// internal to that unit.
+#include "chess-simulator.cpp"
+#include <cstdio>
+
+static const char* const positions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+    "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/8 b - - 3 54",
+    "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+    "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+    "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+    "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+    "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+    "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+    "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+    "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+    // kings on the edge ranks and files, where the shield runs off the board
+    "K6k/P6p/8/8/8/8/8/8 w - - 0 1",
+    "8/8/8/8/8/8/p6P/k6K b - - 0 1",
+    "7K/6PP/8/8/8/8/pp6/k7 w - - 0 1",
+    "4k3/8/8/8/8/8/8/4K3 w - - 0 1",
+};
+
+static constexpr int PLAYOUTS = 20;
+static constexpr int PLAYOUT_PLIES = 200;
+
+static bool sameState(const EvalState& a, const EvalState& b)
+{
+    return a.score == b.score && a.phase == b.phase && a.bishops[0] == b.bishops[0] &&
+           a.bishops[1] == b.bishops[1] && a.pawnKey == b.pawnKey;
+}
+
+// Returns false and reports the position if the two kernels disagree, or if
+// the incrementally updated state drifted from them.
+static bool check(chess::Board& board, const EvalState& incremental)
+{
+    EvalState scalar = computeEvalStateScalar(board);
+    EvalState bitboard = computeEvalStateBitboard(board);
+    if (!sameState(scalar, bitboard))
+    {
+        std::printf("eval state differs: scalar %d, bitboard %d in %s\n", evaluateIncremental(scalar),
+                    evaluateIncremental(bitboard), board.getFen().c_str());
+        return false;
+    }
+
+    if (!sameState(incremental, bitboard))
+    {
+        std::printf("incremental state differs: full %d, incremental %d in %s\n", evaluateIncremental(bitboard),
+                    evaluateIncremental(incremental), board.getFen().c_str());
+        return false;
+    }
+
+    int scalarKing = evaluateKingSafetyScalar(board);
+    int bitboardKing = evaluateKingSafetyBitboard(board);
+    if (scalarKing != bitboardKing)
+    {
+        std::printf("king safety differs: scalar %d, bitboard %d in %s\n", scalarKing, bitboardKing,
+                    board.getFen().c_str());
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    initEvalTables();
+
+    // fixed seed, so a failure reproduces
+    std::mt19937_64 random(20261014);
+    int checked = 0;
+    int failures = 0;
+
+    for (const char* fen : positions)
+    {
+        for (int playout = 0; playout < PLAYOUTS; ++playout)
+        {
+            chess::Board board(fen);
+            EvalState incremental = computeEvalState(board);
+            for (int ply = 0; ply <= PLAYOUT_PLIES; ++ply)
+            {
+                ++checked;
+                if (!check(board, incremental))
+                    ++failures;
+
+                chess::Movelist moves;
+                chess::movegen::legalmoves(moves, board);
+                if (moves.empty())
+                    break;
+
+                chess::Move move = moves[std::uniform_int_distribution<int>(0, int(moves.size()) - 1)(random)];
+                updateEvalState(incremental, board, move);
+                board.makeMove(move);
+            }
+        }
+    }
+
+    std::printf("%d positions, %d mismatches\n", checked, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+// Microbenchmarks for the engine's hot paths. The engine keeps its internals
+// in one translation unit, so it is compiled straight into this binary rather
+// than linked through chessbot.
+#include "chess-simulator.cpp"
+#include <benchmark/benchmark.h>
+
+static const char* const positions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+};
+
+static constexpr int POSITION_COUNT = int(std::size(positions));
+
+static EngineState benchEngine;
+
+static std::unique_ptr<SearchThread> threadAt(const benchmark::State& state)
+{
+    auto thread = std::make_unique<SearchThread>(benchEngine, 0);
+    thread->setPosition(chess::Board(positions[state.range(0)]), {});
+    return thread;
+}
+
+static void BM_LegalMoves(benchmark::State& state)
+{
+    chess::Board board(positions[state.range(0)]);
+    for (auto _ : state)
+    {
+        chess::Movelist moves;
+        chess::movegen::legalmoves(moves, board);
+        benchmark::DoNotOptimize(moves.size());
+    }
+}
+BENCHMARK(BM_LegalMoves)->DenseRange(0, POSITION_COUNT - 1);
+
+static void BM_Evaluate(benchmark::State& state)
+{
+    auto thread = threadAt(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(thread->evaluate());
+}
+BENCHMARK(BM_Evaluate)->DenseRange(0, POSITION_COUNT - 1);
+
+static void BM_ComputeEvalState(benchmark::State& state)
+{
+    initEvalTables();
+    chess::Board board(positions[state.range(0)]);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(computeEvalState(board));
+}
+BENCHMARK(BM_ComputeEvalState)->DenseRange(0, POSITION_COUNT - 1);
+
+static void BM_EvaluateIncremental(benchmark::State& state)
+{
+    auto thread = threadAt(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(evaluateIncremental(thread->evalStack[0]));
+}
+BENCHMARK(BM_EvaluateIncremental)->DenseRange(0, POSITION_COUNT - 1);
+
+// Uncached: the pawn hash normally absorbs almost all of these calls.
+static void BM_PawnStructure(benchmark::State& state)
+{
+    initEvalTables();
+    chess::Board board(positions[state.range(0)]);
+    uint64_t whitePawns = board.pieces(chess::PieceType::PAWN, chess::Color::WHITE).getBits();
+    uint64_t blackPawns = board.pieces(chess::PieceType::PAWN, chess::Color::BLACK).getBits();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(whitePawns);
+        benchmark::DoNotOptimize(pawnStructureScore(whitePawns, blackPawns));
+    }
+}
+BENCHMARK(BM_PawnStructure)->DenseRange(0, POSITION_COUNT - 1);
+
+static void BM_Mobility(benchmark::State& state)
+{
+    chess::Board board(positions[state.range(0)]);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(evaluateMobility(board));
+}
+BENCHMARK(BM_Mobility)->DenseRange(0, POSITION_COUNT - 1);
+
+static void BM_MobilityExact(benchmark::State& state)
+{
+    chess::Board board(positions[state.range(0)]);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(evaluateMobilityExact(board));
+}
+BENCHMARK(BM_MobilityExact)->DenseRange(0, POSITION_COUNT - 1);
+
+static void BM_KingSafety(benchmark::State& state)
+{
+    initEvalTables();
+    chess::Board board(positions[state.range(0)]);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(evaluateKingSafety(board));
+}
+BENCHMARK(BM_KingSafety)->DenseRange(0, POSITION_COUNT - 1);
+
+static void BM_OrderMoves(benchmark::State& state)
+{
+    auto thread = threadAt(state);
+    chess::Movelist legal;
+    chess::movegen::legalmoves(legal, thread->board);
+    for (auto _ : state)
+    {
+        chess::Movelist moves = legal;
+        thread->orderMoves(moves, 1);
+        benchmark::DoNotOptimize(moves[0]);
+    }
+}
+BENCHMARK(BM_OrderMoves)->DenseRange(0, POSITION_COUNT - 1);
+
+static void BM_See(benchmark::State& state)
+{
+    chess::Board board(positions[state.range(0)]);
+    chess::Movelist captures;
+    chess::movegen::legalmoves<chess::movegen::MoveGenType::CAPTURE>(captures, board);
+    for (auto _ : state)
+    {
+        int total = 0;
+        for (auto move : captures)
+            total += see(board, move);
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * captures.size());
+}
+BENCHMARK(BM_See)->DenseRange(0, POSITION_COUNT - 1);
+
+static void BM_Quiescence(benchmark::State& state)
+{
+    auto thread = threadAt(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(thread->quiescence(-INF, INF, 0));
+    state.counters["nodes/call"] = benchmark::Counter(double(thread->nodes) / double(state.iterations()));
+}
+BENCHMARK(BM_Quiescence)->DenseRange(0, POSITION_COUNT - 1);
+
+BENCHMARK_MAIN();
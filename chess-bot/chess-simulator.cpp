@@ -5,65 +5,489 @@
 #include <algorithm>
 #include <random>
 #include <array>
+#include <bit>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define CHESS_BOOK_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef CHESS_SYZYGY
+#include "tbprobe.h"
+#endif
 
 using namespace ChessSimulator;
 
-static constexpr int INF = 1000000;
-static constexpr int MATE_SCORE = 100000;
-static constexpr int MAX_DEPTH = 7;
-static uint64_t repetitionTable[1024];
-static std::chrono::high_resolution_clock::time_point searchStart;
-static int timeLimitMsGlobal;
+// scores must fit the 16-bit TT field
+static constexpr int INF = 32767;
+static constexpr int MATE_SCORE = 32000;
+static constexpr int MATE_IN_MAX = MATE_SCORE - 256;
+// Tablebase wins rank below every mate and above every evaluation.
+static constexpr int TB_WIN_SCORE = MATE_IN_MAX - 1;
+// Every per-ply stack is MAX_PLY deep; the search never goes past it.
+static constexpr int MAX_PLY = 128;
+// extensions and quiescence need room past the deepest iteration
+static_assert(MAX_DEPTH <= MAX_PLY - 28);
+static constexpr int TB_WIN_IN_MAX = TB_WIN_SCORE - MAX_PLY;
+static constexpr int ASPIRATION_DEPTH = 4;
+static constexpr int ASPIRATION_WINDOW = 25;
+static constexpr int MAX_THREADS = 64;
+// Moves remembered per node for the history penalty; later ones go unpunished.
+static constexpr int MAX_QUIETS_TRIED = 64;
+static constexpr int MAX_CAPTURES_TRIED = 32;
+static constexpr uint64_t TIME_CHECK_NODES = 1024;
+
+// Counters that cost a memory write per node are only compiled in on request.
+#ifdef CHESS_SEARCH_STATS
+#define CHESS_STAT(expr) (expr)
+#else
+#define CHESS_STAT(expr) ((void)0)
+#endif
+
+// Splits the per-move budget into a hard limit the search never runs past and
+// a soft limit after which no new iteration is started, since one that starts
+// late rarely finishes. The soft limit shrinks while the best move holds
+// steady across iterations and grows right after it changes. The fields are
+// atomic so that SetTimeLimit() can restart the clock of a running search.
+struct TimeManager {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point searchStart;
+    std::atomic<Clock::time_point> start{};
+    std::atomic<int64_t> softLimitMs{0};
+    std::atomic<int64_t> hardLimitMs{0};
+
+    void init(int timeLimitMs)
+    {
+        searchStart = Clock::now();
+        restart(timeLimitMs);
+    }
+
+    // A new budget counted from now; the search's own start time is kept.
+    void restart(int timeLimitMs)
+    {
+        int64_t limit = std::max(timeLimitMs, 1);
+        int64_t hard = std::max<int64_t>(1, limit - std::min<int64_t>(50, limit / 10));
+        start.store(Clock::now(), std::memory_order_relaxed);
+        hardLimitMs.store(hard, std::memory_order_relaxed);
+        softLimitMs.store(hard / 2, std::memory_order_relaxed);
+    }
+
+    int64_t searchTimeMs() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - searchStart).count();
+    }
+
+    int64_t elapsedMs() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start.load(std::memory_order_relaxed)).count();
+    }
+
+    bool hardLimitReached() const { return elapsedMs() >= hardLimitMs.load(std::memory_order_relaxed); }
+
+    bool shouldStartIteration(int stableIterations) const
+    {
+        static constexpr int stabilityPercent[] = { 130, 110, 100, 80, 65, 50 };
+        int percent = stabilityPercent[std::min(stableIterations, 5)];
+        int64_t hard = hardLimitMs.load(std::memory_order_relaxed);
+        int64_t soft = softLimitMs.load(std::memory_order_relaxed);
+        return elapsedMs() < std::min(hard, soft * percent / 100);
+    }
+};
 
-bool outOfTime() {
-    auto now = std::chrono::high_resolution_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - searchStart).count();
-    return elapsed >= timeLimitMsGlobal;
-}
 //Hi
 enum NodeType { EXACT, LOWERBOUND, UPPERBOUND };
 
 struct TTEntry {
-    uint64_t hash;
+    chess::Move move;
     int depth;
     int score;
     NodeType type;
 };
 
+// 16-byte slot. The data word packs move:16 | score:16 | depth:8 | bound:2 |
+// age:6; the key word holds hash ^ data, so the slot verifies against the
+// full hash and a slot torn by two writers simply fails the check. This keeps
+// the table safe to share between search threads without locks.
+struct TTSlot {
+    std::atomic<uint64_t> key;
+    std::atomic<uint64_t> data;
+};
+
+// Four slots fill one cache line, so a probe costs at most one miss.
+struct alignas(64) TTBucket {
+    TTSlot slots[4];
+};
+
+inline uint64_t packTT(chess::Move move, int depth, int score, NodeType type, uint8_t age)
+{
+    return uint64_t(move.move())
+         | uint64_t(uint16_t(int16_t(score))) << 16
+         | uint64_t(uint8_t(depth)) << 32
+         | uint64_t(type + 1) << 40
+         | uint64_t(age & 63) << 42;
+}
+
+inline int ttDepth(uint64_t data) { return uint8_t(data >> 32); }
+inline int ttBound(uint64_t data) { return int((data >> 40) & 3); }
+inline int ttAge(uint64_t data) { return int((data >> 42) & 63); }
+
+// Mate and tablebase scores are stored relative to the node rather than the root.
+inline int scoreToTT(int score, int ply)
+{
+    if (score >= TB_WIN_IN_MAX) return score + ply;
+    if (score <= -TB_WIN_IN_MAX) return score - ply;
+    return score;
+}
+
+inline int scoreFromTT(int score, int ply)
+{
+    if (score >= TB_WIN_IN_MAX) return score - ply;
+    if (score <= -TB_WIN_IN_MAX) return score + ply;
+    return score;
+}
+
+// The table is kept across Move() calls; every search bumps the generation so
+// entries left over from earlier moves can be recognised and replaced first.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(int megabytes) { resize(megabytes); }
+
+    void resize(int megabytes);
+    void clear();
+    void newSearch() { ++generation; }
+    void resetGeneration() { generation = 0; }
+
+    bool probe(uint64_t hash, TTEntry& entry);
+    void store(uint64_t hash, int depth, int score, NodeType type, chess::Move move);
+
+private:
+    std::unique_ptr<TTBucket[]> buckets;
+    size_t bucketCount = 0;
+    uint8_t generation = 0;
+
+    TTBucket& bucket(uint64_t hash) { return buckets[hash & (bucketCount - 1)]; }
+};
+
+void TranspositionTable::resize(int megabytes)
+{
+    size_t bytes = size_t(std::max(1, megabytes)) << 20;
+    size_t count = 1;
+    while (count * 2 * sizeof(TTBucket) <= bytes)
+        count *= 2;
+
+    // free the old table first so a resize never holds both
+    buckets.reset();
+    buckets.reset(new TTBucket[count]());
+    bucketCount = count;
+}
+
+inline bool TranspositionTable::probe(uint64_t hash, TTEntry& entry)
+{
+    for (TTSlot& slot : bucket(hash).slots)
+    {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t key = slot.key.load(std::memory_order_relaxed);
+
+        if ((key ^ data) != hash || ttBound(data) == 0)
+            continue;
+
+        entry.move = chess::Move(uint16_t(data));
+        entry.score = int16_t(data >> 16);
+        entry.depth = ttDepth(data);
+        entry.type = NodeType(ttBound(data) - 1);
+        return true;
+    }
+
+    return false;
+}
+
+inline void TranspositionTable::store(uint64_t hash, int depth, int score, NodeType type, chess::Move move)
+{
+    TTSlot* replace = nullptr;
+    int replaceWorth = INF;
+
+    for (TTSlot& slot : bucket(hash).slots)
+    {
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t key = slot.key.load(std::memory_order_relaxed);
+
+        if ((key ^ data) == hash)
+        {
+            // same position: keep a deeper result from this search
+            if (ttAge(data) == (generation & 63) && ttDepth(data) > depth && type != EXACT)
+                return;
+            if (move == chess::Move(chess::Move::NO_MOVE))
+                move = chess::Move(uint16_t(data));
+            replace = &slot;
+            break;
+        }
+
+        // empty slots first, then shallow entries, with older searches
+        // counting as shallower the longer ago they were written
+        int age = (generation - ttAge(data)) & 63;
+        int worth = ttBound(data) == 0 ? -INF : ttDepth(data) - 4 * age;
+        if (worth < replaceWorth)
+        {
+            replaceWorth = worth;
+            replace = &slot;
+        }
+    }
+
+    uint64_t data = packTT(move, depth, score, type, generation);
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->key.store(hash ^ data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < bucketCount; ++i)
+    {
+        for (TTSlot& slot : buckets[i].slots)
+        {
+            slot.data.store(0, std::memory_order_relaxed);
+            slot.key.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Polyglot opening book: 16-byte big-endian entries of key, move, weight and
+// learn data, sorted by key. The library's Zobrist keys are the Polyglot
+// Random64 ones, so board.hash() is the book key. Natively the file is mapped
+// and only the pages a probe touches are read; elsewhere it is loaded whole,
+// which in the browser means from the module's embedded file system.
+class OpeningBook {
+public:
+    OpeningBook() = default;
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+    ~OpeningBook() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+    bool loaded() const { return entryCount > 0; }
+    chess::Move probe(const chess::Board& board, const chess::Movelist& legal, std::mt19937_64& random) const;
+
+private:
+    static constexpr size_t ENTRY_SIZE = 16;
+    static constexpr uint64_t STARTPOS_KEY = 0x463b96181691fc9cULL;
+
+    const unsigned char* data = nullptr;
+    size_t entryCount = 0;
+    size_t mappedSize = 0;
+    std::vector<unsigned char> buffer;
+
+    uint64_t read(size_t index, size_t offset, int bytes) const
+    {
+        const unsigned char* p = data + index * ENTRY_SIZE + offset;
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value = (value << 8) | p[i];
+        return value;
+    }
+    uint64_t key(size_t index) const { return read(index, 0, 8); }
+};
+
+bool OpeningBook::open(const std::string& path)
+{
+    close();
+
+    // a library with other hash keys would never find a position
+    if (chess::Board().hash() != STARTPOS_KEY)
+        return false;
+
+#ifdef CHESS_BOOK_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info {};
+    if (fstat(fd, &info) == 0 && size_t(info.st_size) >= ENTRY_SIZE)
+    {
+        void* view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED)
+        {
+            madvise(view, size_t(info.st_size), MADV_RANDOM);
+            data = static_cast<const unsigned char*>(view);
+            mappedSize = size_t(info.st_size);
+        }
+    }
+    ::close(fd);
+#else
+    if (FILE* file = std::fopen(path.c_str(), "rb"))
+    {
+        unsigned char chunk[4096];
+        size_t count;
+        while ((count = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+            buffer.insert(buffer.end(), chunk, chunk + count);
+        std::fclose(file);
+        data = buffer.data();
+    }
+#endif
 
-static constexpr int TT_SIZE = 1 << 22;
-static TTEntry transTable[TT_SIZE];
+    size_t size = mappedSize > 0 ? mappedSize : buffer.size();
+    entryCount = data ? size / ENTRY_SIZE : 0;
+    if (!loaded())
+        close();
+    return loaded();
+}
 
-inline TTEntry* probeTT(uint64_t hash)
+void OpeningBook::close()
 {
-    return &transTable[hash & (TT_SIZE - 1)];
+#ifdef CHESS_BOOK_MMAP
+    if (mappedSize > 0)
+        munmap(const_cast<unsigned char*>(data), mappedSize);
+#endif
+    data = nullptr;
+    entryCount = 0;
+    mappedSize = 0;
+    buffer.clear();
+    buffer.shrink_to_fit();
 }
 
-inline void storeTT(uint64_t hash, int depth, int score, NodeType type)
+// Picks one of the book moves of the position, each with a chance
+// proportional to its weight; NO_MOVE if the book has none.
+chess::Move OpeningBook::probe(const chess::Board& board, const chess::Movelist& legal, std::mt19937_64& random) const
 {
-    TTEntry* entry = probeTT(hash);
+    uint64_t hash = board.hash();
+    size_t low = 0;
+    size_t high = entryCount;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (key(middle) < hash)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    chess::Move candidates[64];
+    uint32_t weights[64];
+    int count = 0;
+    uint64_t total = 0;
+    for (size_t i = low; i < entryCount && key(i) == hash && count < 64; ++i)
+    {
+        uint32_t weight = uint32_t(read(i, 10, 2));
+        uint32_t encoded = uint32_t(read(i, 8, 2));
+        if (weight == 0)
+            continue;
+
+        // to, from and promotion piece; castling is stored as the king taking
+        // its rook, which is how the library encodes it too
+        for (chess::Move move : legal)
+        {
+            uint32_t promotion = move.typeOf() == chess::Move::PROMOTION ? uint32_t(int(move.promotionType())) : 0;
+            uint32_t bookMove = uint32_t(move.to().index()) | uint32_t(move.from().index()) << 6 | promotion << 12;
+            if (bookMove == encoded)
+            {
+                candidates[count] = move;
+                weights[count++] = weight;
+                total += weight;
+                break;
+            }
+        }
+    }
 
-    if (entry->depth <= depth)
+    if (total == 0)
+        return chess::Move(chess::Move::NO_MOVE);
+
+    uint64_t pick = std::uniform_int_distribution<uint64_t>(0, total - 1)(random);
+    for (int i = 0; i < count; ++i)
     {
-        entry->hash = hash;
-        entry->depth = depth;
-        entry->score = score;
-        entry->type  = type;
+        if (pick < weights[i])
+            return candidates[i];
+        pick -= weights[i];
     }
+    return candidates[count - 1];
+}
+
+#ifdef CHESS_SYZYGY
+// Syzygy tablebases through Fathom. They are process-wide, shared by every
+// engine. tb_init() only lists the files; each table is mapped the first time
+// a probe needs it, so configured but unused tables cost neither startup time
+// nor memory.
+static std::atomic<int> syzygyPieces{0};
+// tb_probe_wdl() is thread-safe but tb_probe_root() is not, and engines
+// running side by side may all probe their roots at once.
+static std::mutex syzygyRootMutex;
+
+static bool inTablebases(const chess::Board& board)
+{
+    int pieces = syzygyPieces.load(std::memory_order_relaxed);
+    return pieces > 0 && std::popcount(board.occ().getBits()) <= pieces &&
+           !board.castlingRights().has(chess::Color::WHITE) && !board.castlingRights().has(chess::Color::BLACK);
+}
+
+static unsigned enPassantSquare(const chess::Board& board)
+{
+    return board.enpassantSq() == chess::Square::NO_SQ ? 0 : unsigned(board.enpassantSq().index());
+}
+
+// Win, loss or draw with best play, or TB_RESULT_FAILED; Fathom only answers
+// right after a capture or pawn move, when the fifty-move counter is zero.
+static unsigned probeWdl(const chess::Board& board)
+{
+    using chess::PieceType;
+    return tb_probe_wdl(board.us(chess::Color::WHITE).getBits(), board.us(chess::Color::BLACK).getBits(),
+                        board.pieces(PieceType::KING).getBits(), board.pieces(PieceType::QUEEN).getBits(),
+                        board.pieces(PieceType::ROOK).getBits(), board.pieces(PieceType::BISHOP).getBits(),
+                        board.pieces(PieceType::KNIGHT).getBits(), board.pieces(PieceType::PAWN).getBits(),
+                        board.halfMoveClock(), 0, enPassantSquare(board), board.sideToMove() == chess::Color::WHITE);
 }
 
-inline void clearTT()
+static int wdlScore(unsigned wdl, int ply)
 {
-    for (int i = 0; i < TT_SIZE; ++i)
+    // cursed wins and blessed losses are draws under the fifty-move rule
+    if (wdl == TB_WIN)
+        return TB_WIN_SCORE - ply;
+    if (wdl == TB_LOSS)
+        return -TB_WIN_SCORE + ply;
+    return 0;
+}
+
+// The move that keeps the root's result and, among those, makes progress by
+// DTZ; the search alone cannot tell winning moves apart once every child is
+// a tablebase win.
+static chess::Move probeRoot(const chess::Board& board, const chess::Movelist& legal, int& score)
+{
+    using chess::PieceType;
+    std::unique_lock<std::mutex> lock(syzygyRootMutex);
+    unsigned result = tb_probe_root(board.us(chess::Color::WHITE).getBits(), board.us(chess::Color::BLACK).getBits(),
+                                    board.pieces(PieceType::KING).getBits(), board.pieces(PieceType::QUEEN).getBits(),
+                                    board.pieces(PieceType::ROOK).getBits(), board.pieces(PieceType::BISHOP).getBits(),
+                                    board.pieces(PieceType::KNIGHT).getBits(), board.pieces(PieceType::PAWN).getBits(),
+                                    board.halfMoveClock(), 0, enPassantSquare(board),
+                                    board.sideToMove() == chess::Color::WHITE, nullptr);
+    lock.unlock();
+    if (result == TB_RESULT_FAILED || result == TB_RESULT_CHECKMATE || result == TB_RESULT_STALEMATE)
+        return chess::Move(chess::Move::NO_MOVE);
+
+    // Fathom numbers promotions queen 1 to knight 4, the library knight 1 to queen 4
+    unsigned promotes = TB_GET_PROMOTES(result);
+    for (chess::Move move : legal)
     {
-        transTable[i].depth = -1;
-        transTable[i].hash  = 0;
+        bool promotion = move.typeOf() == chess::Move::PROMOTION;
+        if (unsigned(move.from().index()) == TB_GET_FROM(result) && unsigned(move.to().index()) == TB_GET_TO(result) &&
+            (promotion ? 5 - int(move.promotionType()) : 0) == int(promotes))
+        {
+            score = wdlScore(TB_GET_WDL(result), 0);
+            return move;
+        }
     }
+    return chess::Move(chess::Move::NO_MOVE);
 }
-static chess::Move killerMoves[128][2];
-static int historyHeuristic[2][64][64];
+#endif
 
-static const int knightPST[64] = {
+static constexpr int knightPST[64] = {
     -50,-40,-30,-30,-30,-30,-40,-50,
     -40,-20,  0,  0,  0,  0,-20,-40,
     -30,  0, 10, 15, 15, 10,  0,-30,
@@ -74,7 +498,7 @@ static const int knightPST[64] = {
     -50,-40,-30,-30,-30,-30,-40,-50
  };
 
-static const int pawnPST[64] = {
+static constexpr int pawnPST[64] = {
     0,  0,  0,  0,  0,  0,  0,  0,
     5, 10, 10,-20,-20, 10, 10,  5,
     5, -5,-10,  0,  0,-10, -5,  5,
@@ -85,7 +509,7 @@ static const int pawnPST[64] = {
     0,  0,  0,  0,  0,  0,  0,  0
 };
 
-static const int bishopPST[64] = {
+static constexpr int bishopPST[64] = {
     -20,-10,-10,-10,-10,-10,-10,-20,
     -10,  5,  0,  0,  0,  0,  5,-10,
     -10, 10, 10, 10, 10, 10, 10,-10,
@@ -95,7 +519,7 @@ static const int bishopPST[64] = {
     -10,  0,  0,  0,  0,  0,  0,-10,
     -20,-10,-10,-10,-10,-10,-10,-20
  };
-static const int rookPST[64] = {
+static constexpr int rookPST[64] = {
     0,  0,  5, 10, 10,  5,  0,  0,
    -5,  0,  0,  0,  0,  0,  0, -5,
    -5,  0,  0,  0,  0,  0,  0, -5,
@@ -105,7 +529,7 @@ static const int rookPST[64] = {
     5, 10, 10, 10, 10, 10, 10,  5,
     0,  0,  5, 10, 10,  5,  0,  0
 };
-static const int queenPST[64] = {
+static constexpr int queenPST[64] = {
     -20,-10,-10, -5, -5,-10,-10,-20,
     -10,  0,  0,  0,  0,  0,  0,-10,
     -10,  0,  5,  5,  5,  5,  0,-10,
@@ -115,7 +539,39 @@ static const int queenPST[64] = {
     -10,  0,  5,  0,  0,  0,  0,-10,
     -20,-10,-10, -5, -5,-10,-10,-20
 };
-int pieceValue(chess::Piece::underlying p) {
+// Endgame-only tables: pawns gain with every step forward, and the king leaves
+// its shelter for the centre once the heavy pieces are off.
+static constexpr int pawnEgPST[64] = {
+    0,  0,  0,  0,  0,  0,  0,  0,
+   10, 10, 10, 10, 10, 10, 10, 10,
+   10, 10, 10, 10, 10, 10, 10, 10,
+   20, 20, 20, 20, 20, 20, 20, 20,
+   30, 30, 30, 30, 30, 30, 30, 30,
+   50, 50, 50, 50, 50, 50, 50, 50,
+   80, 80, 80, 80, 80, 80, 80, 80,
+    0,  0,  0,  0,  0,  0,  0,  0
+};
+static constexpr int kingMgPST[64] = {
+    20, 30, 10,  0,  0, 10, 30, 20,
+    20, 20,  0,  0,  0,  0, 20, 20,
+   -10,-20,-20,-20,-20,-20,-20,-10,
+   -20,-30,-30,-40,-40,-30,-30,-20,
+   -30,-40,-40,-50,-50,-40,-40,-30,
+   -30,-40,-40,-50,-50,-40,-40,-30,
+   -30,-40,-40,-50,-50,-40,-40,-30,
+   -30,-40,-40,-50,-50,-40,-40,-30
+};
+static constexpr int kingEgPST[64] = {
+   -50,-30,-30,-30,-30,-30,-30,-50,
+   -30,-30,  0,  0,  0,  0,-30,-30,
+   -30,-10, 20, 30, 30, 20,-10,-30,
+   -30,-10, 30, 40, 40, 30,-10,-30,
+   -30,-10, 30, 40, 40, 30,-10,-30,
+   -30,-10, 20, 30, 30, 20,-10,-30,
+   -30,-20,-10,  0,  0,-10,-20,-30,
+   -50,-40,-30,-20,-20,-30,-40,-50
+};
+constexpr int pieceValue(chess::Piece::underlying p) {
     switch (p) {
         case chess::Piece::underlying::WHITEPAWN:
         case chess::Piece::underlying::BLACKPAWN: return 100;
@@ -130,232 +586,195 @@ int pieceValue(chess::Piece::underlying p) {
         default: return 0;
     }
 }
-int evaluateMaterial(chess::Board& board)
-{
-    int score = 0;
-
-    for (int i = 0; i < 64; ++i)
-    {
-        auto piece = board.at(chess::Square(i)).internal();
-        if (piece == chess::Piece::underlying::NONE) {
-            continue;
-        }
-
-        int val = pieceValue(piece);
-
-        if (chess::Piece(piece).color() == chess::Color::WHITE) {
-            score += val;
-        }
-        else {
-            score -= val;
-        }
-    }
-
-    return score;
-}
-int evaluateMobility(chess::Board& board)
-{
-    chess::Movelist sideMoves;
-    chess::movegen::legalmoves(sideMoves, board);
-    int sideMob = sideMoves.size();
-
-    board.makeNullMove();
+// Midgame and endgame halves of a score packed into one int, endgame in the
+// upper 16 bits. Packed scores add and subtract as plain ints, so one table
+// lookup updates both phases.
+constexpr int S(int mg, int eg) { return int(unsigned(eg) << 16) + mg; }
+constexpr int mgScore(int s) { return int16_t(uint16_t(unsigned(s))); }
+constexpr int egScore(int s) { return int16_t(uint16_t(unsigned(s + 0x8000) >> 16)); }
+static_assert(mgScore(S(-15, 20) + S(5, -40)) == -10 && egScore(S(-15, 20) + S(5, -40)) == -20);
+
+// Incremental evaluation: material, PST, development and center terms are all
+// per-square, so they are folded into one signed table per piece and kept in
+// an accumulator that moves with the search instead of rescanning the board.
+struct EvalState {
+    int score;
+    int phase;
+    int bishops[2];
+    uint64_t pawnKey;
+};
 
-    chess::Movelist oppMoves;
-    chess::movegen::legalmoves(oppMoves, board);
-    int oppMob = oppMoves.size();
+static constexpr int MAX_PHASE = 24;
+static constexpr int phaseWeight[6] = { 0, 1, 1, 2, 4, 0 };
 
-    board.unmakeNullMove();
+// White-relative packed scores, indexed by chess::Piece::underlying and
+// square, with black's entries already mirrored and negated.
+static constexpr auto squareScore = [] {
+    constexpr const int* mgPST[6] = { pawnPST, knightPST, bishopPST, rookPST, queenPST, kingMgPST };
+    constexpr const int* egPST[6] = { pawnEgPST, knightPST, bishopPST, rookPST, queenPST, kingEgPST };
 
-    return (sideMob - oppMob) * 2;
-}
-int evaluateKingSafety(chess::Board& board)
-{
-    int score = 0;
+    std::array<std::array<int, 64>, 12> table{};
 
-    for (int i = 0; i < 64; i++)
+    for (int type = 0; type < 6; ++type)
     {
-        auto piece = board.at(chess::Square(i)).internal();
-        if (piece == chess::Piece::underlying::WHITEKING)
-        {
-            int file = i % 8;
-            int rank = i / 8;
-
-            for (int df = -1; df <= 1; df++)
-            {
-                int f = file + df;
-                int r = rank + 1;
-
-                if (f >= 0 && f < 8 && r < 8)
-                {
-                    int sq = r * 8 + f;
-                    if (board.at(chess::Square(sq)).internal() == chess::Piece::underlying::WHITEPAWN) {
-                        score += 15;
-                    }
-                }
-            }
-        }
+        int value = pieceValue(chess::Piece::underlying(type));
 
-        if (piece == chess::Piece::underlying::BLACKKING)
+        for (int sq = 0; sq < 64; ++sq)
         {
-            int file = i % 8;
-            int rank = i / 8;
-
-            for (int df = -1; df <= 1; df++)
-            {
-                int f = file + df;
-                int r = rank - 1;
-
-                if (f >= 0 && f < 8 && r >= 0)
-                {
-                    int sq = r * 8 + f;
-                    if (board.at(chess::Square(sq)).internal() == chess::Piece::underlying::BLACKPAWN) {
-                        score -= 15;
-                    }
-                }
-            }
+            table[type][sq] = S(value + mgPST[type][sq], value + egPST[type][sq]);
+            table[type + 6][sq] = -S(value + mgPST[type][63 - sq], value + egPST[type][63 - sq]);
         }
     }
 
-    return score;
-}
-int evaluatePawnStructure(chess::Board& board)
-{
-    int score = 0;
+    // development: undeveloped minor pieces on b1/g1, c1/f1 and b8/g8, c8/f8
+    for (int sq : { 1, 6 })
+    {
+        table[int(chess::Piece::underlying::WHITEKNIGHT)][sq] -= S(15, 0);
+        table[int(chess::Piece::underlying::BLACKKNIGHT)][sq ^ 56] += S(15, 0);
+    }
+    for (int sq : { 2, 5 })
+    {
+        table[int(chess::Piece::underlying::WHITEBISHOP)][sq] -= S(15, 0);
+        table[int(chess::Piece::underlying::BLACKBISHOP)][sq ^ 56] += S(15, 0);
+    }
 
-    for (int file = 0; file < 8; file++)
+    // center control: pawns on d4, e4, d5, e5
+    for (int sq : { 27, 28, 35, 36 })
     {
-        int whiteCount = 0;
-        int blackCount = 0;
+        table[int(chess::Piece::underlying::WHITEPAWN)][sq] += S(20, 0);
+        table[int(chess::Piece::underlying::BLACKPAWN)][sq] -= S(20, 0);
+    }
 
-        for (int rank = 0; rank < 8; rank++)
-        {
-            int sq = rank * 8 + file;
-            auto piece = board.at(chess::Square(sq)).internal();
+    return table;
+}();
 
-            if (piece == chess::Piece::underlying::WHITEPAWN) {
-                whiteCount++;
-            }
-            if (piece == chess::Piece::underlying::BLACKPAWN) {
-                blackCount++;
-            }
-        }
+// Pawn-only Zobrist keys and the masks used by the pawn structure terms.
+static uint64_t pawnZobrist[2][64];
+static uint64_t fileMask[8];
+static uint64_t adjacentFilesMask[8];
+static uint64_t passedPawnMask[2][64];
+static uint64_t kingShieldMask[2][64];
 
-        if (whiteCount > 1) {
-            score -= 15 * (whiteCount - 1);
-        }
+void initPawnTables()
+{
+    std::mt19937_64 rng(0x9E3779B97F4A7C15ULL);
+    for (auto& side : pawnZobrist)
+        for (auto& key : side)
+            key = rng();
 
-        if (blackCount > 1) {
-            score += 15 * (blackCount - 1);
-        }
-    }
+    for (int file = 0; file < 8; ++file)
+        fileMask[file] = 0x0101010101010101ULL << file;
 
-    for (int i = 0; i < 64; i++)
+    for (int file = 0; file < 8; ++file)
     {
-        auto piece = board.at(chess::Square(i)).internal();
-        if (piece == chess::Piece::underlying::WHITEPAWN)
-        {
-            int file = i % 8;
-            int rank = i / 8;
-
-            bool passed = true;
-
-            for (int r = rank + 1; r < 8 && passed; r++)
-            {
-                for (int f = file - 1; f <= file + 1; f++)
-                {
-                    if (f >= 0 && f < 8)
-                    {
-                        int sq = r * 8 + f;
-                        if (board.at(chess::Square(sq)).internal() ==  chess::Piece::underlying::BLACKPAWN)
-                        {
-                            passed = false;
-                            break;
-                        }
-                    }
-                }
-            }
-
-            if (passed) {
-                score += (rank * 10);
-            }
-        }
+        adjacentFilesMask[file] = 0;
+        if (file > 0) adjacentFilesMask[file] |= fileMask[file - 1];
+        if (file < 7) adjacentFilesMask[file] |= fileMask[file + 1];
+    }
 
-        if (piece == chess::Piece::underlying::BLACKPAWN)
-        {
-            int file = i % 8;
-            int rank = i / 8;
+    for (int sq = 0; sq < 64; ++sq)
+    {
+        int file = sq % 8;
+        int rank = sq / 8;
+        uint64_t span = fileMask[file] | adjacentFilesMask[file];
 
-            bool passed = true;
+        uint64_t ahead = rank < 7 ? ~0ULL << ((rank + 1) * 8) : 0;
+        uint64_t behind = rank > 0 ? ~0ULL >> ((8 - rank) * 8) : 0;
 
-            for (int r = rank - 1; r >= 0 && passed; r--)
-            {
-                for (int f = file - 1; f <= file + 1; f++)
-                {
-                    if (f >= 0 && f < 8)
-                    {
-                        int sq = r * 8 + f;
-                        if (board.at(chess::Square(sq)).internal() == chess::Piece::underlying::WHITEPAWN)
-                        {
-                            passed = false;
-                            break;
-                        }
-                    }
-                }
-            }
+        passedPawnMask[0][sq] = span & ahead;
+        passedPawnMask[1][sq] = span & behind;
 
-            if (passed) {
-                score -= ((7 - rank) * 10);
-            }
-        }
+        // the three squares directly in front of a king on sq
+        uint64_t shieldFiles = fileMask[file] | adjacentFilesMask[file];
+        kingShieldMask[0][sq] = rank < 7 ? shieldFiles & (0xFFULL << ((rank + 1) * 8)) : 0;
+        kingShieldMask[1][sq] = rank > 0 ? shieldFiles & (0xFFULL << ((rank - 1) * 8)) : 0;
     }
+}
 
-    return score;
+inline void addPiece(EvalState& state, chess::Piece piece, int sq)
+{
+    int p = int(piece.internal());
+    state.score += squareScore[p][sq];
+    state.phase += phaseWeight[p % 6];
+    if (p % 6 == 2)
+        state.bishops[p / 6]++;
+    if (p % 6 == 0)
+        state.pawnKey ^= pawnZobrist[p / 6][sq];
 }
-int evaluatePieceSquare(chess::Board& board)
+
+inline void removePiece(EvalState& state, chess::Piece piece, int sq)
 {
-    int score = 0;
-    int whiteBishops = 0;
-    int blackBishops = 0;
+    int p = int(piece.internal());
+    state.score -= squareScore[p][sq];
+    state.phase -= phaseWeight[p % 6];
+    if (p % 6 == 2)
+        state.bishops[p / 6]--;
+    if (p % 6 == 0)
+        state.pawnKey ^= pawnZobrist[p / 6][sq];
+}
 
-    for (int i = 0; i < 64; i++)
+// The original square-by-square scans are kept as a reference the bitboard
+// versions must match score for score: this one sums each term from the
+// board the way the separate material, PST, development and center passes
+// did, without the folded squareScore table. chessevalcheck compares the
+// two and CHESS_SCALAR_EVAL makes the engine use the scans.
+EvalState computeEvalStateScalar(const chess::Board& board)
+{
+    EvalState state = {};
+
+    for (int i = 0; i < 64; ++i)
     {
         auto piece = board.at(chess::Square(i)).internal();
         if (piece == chess::Piece::underlying::NONE)
             continue;
 
-        int sq = i;
         bool isWhite = chess::Piece(piece).color() == chess::Color::WHITE;
-
-        int pstBonus = 0;
+        int sq = isWhite ? i : 63 - i;
+        int mg = pieceValue(piece);
+        int eg = mg;
 
         switch (piece)
         {
             case chess::Piece::underlying::WHITEPAWN:
             case chess::Piece::underlying::BLACKPAWN:
-                pstBonus = isWhite ? pawnPST[sq] : pawnPST[63 - sq];
+                mg += pawnPST[sq];
+                eg += pawnEgPST[sq];
+                state.pawnKey ^= pawnZobrist[isWhite ? 0 : 1][i];
                 break;
 
             case chess::Piece::underlying::WHITEKNIGHT:
             case chess::Piece::underlying::BLACKKNIGHT:
-                pstBonus = isWhite ? knightPST[sq] : knightPST[63 - sq];
+                mg += knightPST[sq];
+                eg += knightPST[sq];
+                state.phase += 1;
                 break;
 
             case chess::Piece::underlying::WHITEBISHOP:
             case chess::Piece::underlying::BLACKBISHOP:
-                pstBonus = isWhite ? bishopPST[sq] : bishopPST[63 - sq];
-                if (isWhite) whiteBishops++;
-                else blackBishops++;
+                mg += bishopPST[sq];
+                eg += bishopPST[sq];
+                state.phase += 1;
+                state.bishops[isWhite ? 0 : 1]++;
                 break;
 
             case chess::Piece::underlying::WHITEROOK:
             case chess::Piece::underlying::BLACKROOK:
-                pstBonus = isWhite ? rookPST[sq] : rookPST[63 - sq];
+                mg += rookPST[sq];
+                eg += rookPST[sq];
+                state.phase += 2;
                 break;
 
             case chess::Piece::underlying::WHITEQUEEN:
             case chess::Piece::underlying::BLACKQUEEN:
-                pstBonus = isWhite ? queenPST[sq] : queenPST[63 - sq];
+                mg += queenPST[sq];
+                eg += queenPST[sq];
+                state.phase += 4;
+                break;
+
+            case chess::Piece::underlying::WHITEKING:
+            case chess::Piece::underlying::BLACKKING:
+                mg += kingMgPST[sq];
+                eg += kingEgPST[sq];
                 break;
 
             default:
@@ -363,308 +782,1742 @@ int evaluatePieceSquare(chess::Board& board)
         }
 
         if (isWhite)
-            score += pstBonus;
+            state.score += S(mg, eg);
         else
-            score -= pstBonus;
+            state.score -= S(mg, eg);
     }
 
-    if (whiteBishops >= 2) score += 30;
-    if (blackBishops >= 2) score -= 30;
-
-    return score;
-}
-int evaluateDevelopment(chess::Board& board)
-{
-    int score = 0;
-
+    // development
     if (board.at(chess::Square::SQ_B1).internal() == chess::Piece::underlying::WHITEKNIGHT)
-        score -= 15;
+        state.score -= S(15, 0);
     if (board.at(chess::Square::SQ_G1).internal() == chess::Piece::underlying::WHITEKNIGHT)
-        score -= 15;
-
+        state.score -= S(15, 0);
     if (board.at(chess::Square::SQ_B8).internal() == chess::Piece::underlying::BLACKKNIGHT)
-        score += 15;
+        state.score += S(15, 0);
     if (board.at(chess::Square::SQ_G8).internal() == chess::Piece::underlying::BLACKKNIGHT)
-        score += 15;
-
+        state.score += S(15, 0);
     if (board.at(chess::Square::SQ_C1).internal() == chess::Piece::underlying::WHITEBISHOP)
-        score -= 15;
+        state.score -= S(15, 0);
     if (board.at(chess::Square::SQ_F1).internal() == chess::Piece::underlying::WHITEBISHOP)
-        score -= 15;
-
+        state.score -= S(15, 0);
     if (board.at(chess::Square::SQ_C8).internal() == chess::Piece::underlying::BLACKBISHOP)
-        score += 15;
+        state.score += S(15, 0);
     if (board.at(chess::Square::SQ_F8).internal() == chess::Piece::underlying::BLACKBISHOP)
-        score += 15;
-
-    return score;
-}
-int evaluateCenterControl(chess::Board& board)
-{
-    int score = 0;
+        state.score += S(15, 0);
 
-    int centerSquares[4] = { 27, 28, 35, 36 };
-
-    for (int sq : centerSquares)
+    // center control
+    for (int sq : { 27, 28, 35, 36 })
     {
         auto piece = board.at(chess::Square(sq)).internal();
-
         if (piece == chess::Piece::underlying::WHITEPAWN)
-            score += 20;
+            state.score += S(20, 0);
         if (piece == chess::Piece::underlying::BLACKPAWN)
-            score -= 20;
+            state.score -= S(20, 0);
     }
 
-    return score;
+    return state;
 }
 
-int evaluate(chess::Board& board)
+EvalState computeEvalStateBitboard(const chess::Board& board)
 {
-    int score = 0;
+    EvalState state = {};
 
-    score += evaluateMaterial(board);
-    score += evaluatePawnStructure(board);
-    score += evaluateMobility(board);
-    score += evaluateKingSafety(board);
-    score += evaluatePieceSquare(board);
-    score += evaluateDevelopment(board);
-    score += evaluateCenterControl(board);
-    return (board.sideToMove() == chess::Color::WHITE) ? score : -score;
-}
+    for (int p = 0; p < 12; ++p)
+    {
+        chess::Piece piece{ chess::Piece::underlying(p) };
+        chess::Bitboard pieces = board.pieces(piece.type(), piece.color());
+        while (!pieces.empty())
+            addPiece(state, piece, pieces.pop());
+    }
 
+    return state;
+}
 
-int captureScore(chess::Board& board, chess::Move move) {
-    auto victim = board.at(move.to()).internal();
-    auto attacker = board.at(move.from()).internal();
-    return pieceValue(victim) - pieceValue(attacker);
+EvalState computeEvalState(const chess::Board& board)
+{
+#ifdef CHESS_SCALAR_EVAL
+    return computeEvalStateScalar(board);
+#else
+    return computeEvalStateBitboard(board);
+#endif
 }
 
-int scoreMove(chess::Board& board, chess::Move move, int depth) {
-    if (board.isCapture(move))
-        return 100000 + captureScore(board, move);
+// Must be called on the position before the move is made.
+void updateEvalState(EvalState& state, const chess::Board& board, chess::Move move)
+{
+    int from = move.from().index();
+    int to = move.to().index();
+    auto moving = board.at(move.from());
+
+    if (move.typeOf() == chess::Move::CASTLING)
+    {
+        // encoded as king takes own rook
+        bool kingSide = to > from;
+        int rankBase = from & 56;
+        auto rook = board.at(move.to());
+
+        removePiece(state, moving, from);
+        removePiece(state, rook, to);
+        addPiece(state, moving, rankBase + (kingSide ? 6 : 2));
+        addPiece(state, rook, rankBase + (kingSide ? 5 : 3));
+        return;
+    }
 
-    if (move == killerMoves[depth][0])
-        return 90000;
+    if (move.typeOf() == chess::Move::ENPASSANT)
+    {
+        removePiece(state, chess::Piece(chess::PieceType::PAWN, ~moving.color()), to ^ 8);
+    }
+    else
+    {
+        auto captured = board.at(move.to());
+        if (captured != chess::Piece::underlying::NONE)
+            removePiece(state, captured, to);
+    }
 
-    if (move == killerMoves[depth][1])
-        return 80000;
+    removePiece(state, moving, from);
 
-    int side = (board.sideToMove() == chess::Color::WHITE) ? 0 : 1;
-    return historyHeuristic[side][move.from().index()][move.to().index()];
+    if (move.typeOf() == chess::Move::PROMOTION)
+        addPiece(state, chess::Piece(move.promotionType(), moving.color()), to);
+    else
+        addPiece(state, moving, to);
 }
 
-void orderMoves(chess::Movelist& moves, chess::Board& board, int depth) {
-    std::sort(moves.begin(), moves.end(),
-        [&](const chess::Move& a, const chess::Move& b) {
-            return scoreMove(board, a, depth) >
-                   scoreMove(board, b, depth);
-        });
+void initEvalTables()
+{
+    static const bool ready = [] {
+        initPawnTables();
+        return true;
+    }();
+    (void)ready;
 }
 
-int quiescence(chess::Board& board, int alpha, int beta) {
-    int standPat = evaluate(board);
+int evaluateIncremental(const EvalState& state)
+{
 
-    if (standPat >= beta)
-        return beta;
+    int phase = std::min(state.phase, MAX_PHASE);
+    int score = (mgScore(state.score) * phase + egScore(state.score) * (MAX_PHASE - phase)) / MAX_PHASE;
 
-    if (alpha < standPat)
-        alpha = standPat;
+    if (state.bishops[0] >= 2) score += 30;
+    if (state.bishops[1] >= 2) score -= 30;
 
-    chess::Movelist moves;
-    chess::movegen::legalmoves(moves, board);
+    return score;
+}
+// Exact mobility: legal move counts for both sides, via a null move.
+int evaluateMobilityExact(chess::Board& board)
+{
+    chess::Movelist sideMoves;
+    chess::movegen::legalmoves(sideMoves, board);
+    int sideMob = sideMoves.size();
 
-    for (auto move : moves) {
-        if (!board.isCapture(move))
-            continue;
+    board.makeNullMove();
 
-        board.makeMove(move);
-        int score = -quiescence(board, -beta, -alpha);
-        board.unmakeMove(move);
+    chess::Movelist oppMoves;
+    chess::movegen::legalmoves(oppMoves, board);
+    int oppMob = oppMoves.size();
 
-        if (score >= beta)
-            return beta;
+    board.unmakeNullMove();
 
-        if (score > alpha)
-            alpha = score;
-    }
+    int score = (sideMob - oppMob) * 2;
+    return (board.sideToMove() == chess::Color::WHITE) ? score : -score;
+}
 
-    return alpha;
+// Squares attacked by knights, bishops, rooks and queens that are not
+// occupied by own pieces. Pseudo-legal: pins and checks are ignored.
+int pieceMobility(const chess::Board& board, chess::Color color)
+{
+    chess::Bitboard occ = board.occ();
+    chess::Bitboard targets = ~board.us(color);
+    int count = 0;
+
+    chess::Bitboard knights = board.pieces(chess::PieceType::KNIGHT, color);
+    while (!knights.empty())
+        count += (chess::attacks::knight(chess::Square(knights.pop())) & targets).count();
+
+    chess::Bitboard bishops = board.pieces(chess::PieceType::BISHOP, color);
+    while (!bishops.empty())
+        count += (chess::attacks::bishop(chess::Square(bishops.pop()), occ) & targets).count();
+
+    chess::Bitboard rooks = board.pieces(chess::PieceType::ROOK, color);
+    while (!rooks.empty())
+        count += (chess::attacks::rook(chess::Square(rooks.pop()), occ) & targets).count();
+
+    chess::Bitboard queens = board.pieces(chess::PieceType::QUEEN, color);
+    while (!queens.empty())
+        count += (chess::attacks::queen(chess::Square(queens.pop()), occ) & targets).count();
+
+    return count;
 }
 
-int alphaBeta(chess::Board& board, int depth, int alpha, int beta, int ply)
+int evaluateMobility(chess::Board& board)
 {
-    if (outOfTime()) {
-        return evaluate(board);
-    }
-    uint64_t hash = board.hash();
+    int white = pieceMobility(board, chess::Color::WHITE);
+    int black = pieceMobility(board, chess::Color::BLACK);
+    return (white - black) * 2;
+}
 
-    int repetitionCount = 0;
+int evaluateKingSafetyScalar(chess::Board& board)
+{
+    int score = 0;
 
-    for (int i = 0; i < ply; ++i)
+    for (int i = 0; i < 64; i++)
     {
-        if (repetitionTable[i] == hash)
+        auto piece = board.at(chess::Square(i)).internal();
+        if (piece == chess::Piece::underlying::WHITEKING)
+        {
+            int file = i % 8;
+            int rank = i / 8;
+
+            for (int df = -1; df <= 1; df++)
+            {
+                int f = file + df;
+                int r = rank + 1;
+
+                if (f >= 0 && f < 8 && r < 8)
+                {
+                    int sq = r * 8 + f;
+                    if (board.at(chess::Square(sq)).internal() == chess::Piece::underlying::WHITEPAWN) {
+                        score += 15;
+                    }
+                }
+            }
+        }
+
+        if (piece == chess::Piece::underlying::BLACKKING)
         {
-            repetitionCount++;
-            if (repetitionCount >= 2)
+            int file = i % 8;
+            int rank = i / 8;
+
+            for (int df = -1; df <= 1; df++)
             {
-                return 0;
+                int f = file + df;
+                int r = rank - 1;
+
+                if (f >= 0 && f < 8 && r >= 0)
+                {
+                    int sq = r * 8 + f;
+                    if (board.at(chess::Square(sq)).internal() == chess::Piece::underlying::BLACKPAWN) {
+                        score -= 15;
+                    }
+                }
             }
         }
     }
-    if (depth == 0)
-        return quiescence(board, alpha, beta);
 
-    auto gameOver = board.isGameOver();
-    if (gameOver.second != chess::GameResult::NONE)
+    return score;
+}
+
+// Pawn shield: own pawns on the three squares in front of each king.
+int evaluateKingSafetyBitboard(chess::Board& board)
+{
+    uint64_t whitePawns = board.pieces(chess::PieceType::PAWN, chess::Color::WHITE).getBits();
+    uint64_t blackPawns = board.pieces(chess::PieceType::PAWN, chess::Color::BLACK).getBits();
+    int whiteKing = board.kingSq(chess::Color::WHITE).index();
+    int blackKing = board.kingSq(chess::Color::BLACK).index();
+
+    return 15 * (std::popcount(kingShieldMask[0][whiteKing] & whitePawns)
+               - std::popcount(kingShieldMask[1][blackKing] & blackPawns));
+}
+
+int evaluateKingSafety(chess::Board& board)
+{
+#ifdef CHESS_SCALAR_EVAL
+    return evaluateKingSafetyScalar(board);
+#else
+    return evaluateKingSafetyBitboard(board);
+#endif
+}
+// Pawn terms only depend on pawn placement, so they are cached by pawn key.
+struct PawnEntry {
+    uint64_t key;
+    int score;
+};
+
+static constexpr int PAWN_HASH_SIZE = 1 << 14;
+
+int pawnStructureScore(uint64_t whitePawns, uint64_t blackPawns)
+{
+    int score = 0;
+
+    for (int file = 0; file < 8; file++)
     {
-        if (gameOver.second == chess::GameResult::DRAW)
-            return 0;
-        return -MATE_SCORE + ply;
+        int whiteCount = std::popcount(whitePawns & fileMask[file]);
+        int blackCount = std::popcount(blackPawns & fileMask[file]);
+
+        if (whiteCount > 1) {
+            score -= 15 * (whiteCount - 1);
+        }
+
+        if (blackCount > 1) {
+            score += 15 * (blackCount - 1);
+        }
     }
 
-    TTEntry* tt = probeTT(hash);
+    for (uint64_t pawns = whitePawns; pawns; pawns &= pawns - 1)
+    {
+        int sq = std::countr_zero(pawns);
+        if (!(passedPawnMask[0][sq] & blackPawns)) {
+            score += (sq / 8) * 10;
+        }
+    }
 
-    if (tt->hash == hash && tt->depth >= depth)
+    for (uint64_t pawns = blackPawns; pawns; pawns &= pawns - 1)
     {
-        if (tt->type == EXACT)
-            return tt->score;
+        int sq = std::countr_zero(pawns);
+        if (!(passedPawnMask[1][sq] & whitePawns)) {
+            score -= (7 - sq / 8) * 10;
+        }
+    }
 
-        else if (tt->type == LOWERBOUND)
-            alpha = std::max(alpha, tt->score);
+    return score;
+}
 
-        else if (tt->type == UPPERBOUND)
-            beta = std::min(beta, tt->score);
+// Value of the piece a capture removes; en passant lands on an empty square.
+int capturedValue(const chess::Board& board, chess::Move move) {
+    if (move.typeOf() == chess::Move::ENPASSANT)
+        return pieceValue(chess::Piece::underlying::WHITEPAWN);
+    return pieceValue(board.at(move.to()).internal());
+}
 
-        if (alpha >= beta)
-            return tt->score;
-    }
+// MVV-LVA: the most valuable victim first, the cheapest attacker breaking ties.
+int captureScore(chess::Board& board, chess::Move move) {
+    auto attacker = board.at(move.from()).internal();
+    return capturedValue(board, move) * 8 - pieceValue(attacker);
+}
 
-    chess::Movelist moves;
-    chess::movegen::legalmoves(moves, board);
-    orderMoves(moves, board, ply);
+// Exchange values by PieceType; the king is priced out of ever being traded.
+static constexpr int seeValue[7] = { 100, 320, 330, 500, 900, 20000, 0 };
 
-    int originalAlpha = alpha;
-    int bestScore = -INF;
-    bool firstMove = true;
+static uint64_t attackersTo(const chess::Board& board, chess::Square sq, uint64_t occ)
+{
+    using chess::PieceType;
+    chess::Bitboard occupancy(occ);
+
+    uint64_t bishopsQueens = (board.pieces(PieceType::BISHOP) | board.pieces(PieceType::QUEEN)).getBits();
+    uint64_t rooksQueens = (board.pieces(PieceType::ROOK) | board.pieces(PieceType::QUEEN)).getBits();
+
+    return (chess::attacks::pawn(chess::Color::BLACK, sq) & board.pieces(PieceType::PAWN, chess::Color::WHITE)).getBits()
+         | (chess::attacks::pawn(chess::Color::WHITE, sq) & board.pieces(PieceType::PAWN, chess::Color::BLACK)).getBits()
+         | (chess::attacks::knight(sq) & board.pieces(PieceType::KNIGHT)).getBits()
+         | (chess::attacks::king(sq) & board.pieces(PieceType::KING)).getBits()
+         | (chess::attacks::bishop(sq, occupancy).getBits() & bishopsQueens)
+         | (chess::attacks::rook(sq, occupancy).getBits() & rooksQueens);
+}
 
-    for (auto move : moves)
-    {
-        repetitionTable[ply] = hash;
-        board.makeMove(move);
+// Static exchange evaluation: the material outcome of the capture sequence on
+// the target square, both sides recapturing with their least valuable piece.
+// Sliders behind a piece that has moved join in as x-rays.
+int see(const chess::Board& board, chess::Move move)
+{
+    if (move.typeOf() == chess::Move::CASTLING)
+        return 0;
 
-        int score;
+    chess::Square to = move.to();
+    uint64_t occ = board.occ().getBits();
+    uint64_t fromSet = 1ULL << move.from().index();
 
-        if (firstMove)
-        {
-            score = -alphaBeta(board, depth - 1, -beta, -alpha, ply + 1);
-            firstMove = false;
-        }
-        else
-        {
-            score = -alphaBeta(board, depth - 1, -alpha - 1, -alpha, ply + 1);
+    int gain[32];
+    int d = 0;
+    int attackerType = int(board.at(move.from()).type());
 
-            if (score > alpha && score < beta) {
-                score = -alphaBeta(board, depth - 1, -beta, -alpha, ply + 1);
-            }
-        }
+    if (move.typeOf() == chess::Move::ENPASSANT)
+    {
+        gain[0] = seeValue[int(chess::PieceType::PAWN)];
+        occ ^= 1ULL << (to.index() ^ 8);
+    }
+    else
+    {
+        gain[0] = seeValue[int(board.at(to).type())];
+    }
 
-        board.unmakeMove(move);
+    chess::Color side = board.sideToMove();
 
-        if (score > bestScore)
-            bestScore = score;
+    do
+    {
+        ++d;
+        side = ~side;
+        gain[d] = seeValue[attackerType] - gain[d - 1];
 
-        if (score > alpha)
-        {
-            alpha = score;
+        // Neither side can improve on stopping here.
+        if (std::max(-gain[d - 1], gain[d]) < 0)
+            break;
 
-            if (!board.isCapture(move))
-            {
-                killerMoves[ply][1] = killerMoves[ply][0];
-                killerMoves[ply][0] = move;
+        occ ^= fromSet;
+        uint64_t attackers = attackersTo(board, to, occ) & occ;
 
-                int side = (board.sideToMove() == chess::Color::WHITE) ? 0 : 1;
-                historyHeuristic[side][move.from().index()][move.to().index()] += depth * depth;
+        uint64_t own = attackers & board.us(side).getBits();
+        fromSet = 0;
+        for (int pt = 0; pt < 6 && own; ++pt)
+        {
+            uint64_t bb = own & board.pieces(chess::PieceType(static_cast<chess::PieceType::underlying>(pt)), side).getBits();
+            if (bb)
+            {
+                fromSet = bb & (0 - bb);
+                attackerType = pt;
+                break;
             }
         }
+    } while (fromSet && d < 31);
 
-        if (alpha >= beta)
-            break;
-    }
+    while (--d)
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
 
-    NodeType type;
-    if (bestScore <= originalAlpha)
-        type = UPPERBOUND;
-    else if (bestScore >= beta)
-        type = LOWERBOUND;
-    else
-        type = EXACT;
+    return gain[0];
+}
 
-    storeTT(hash, depth, bestScore, type);
+// Per-thread search state. Lazy SMP: every thread runs its own iterative
+// deepening on its own board and heuristics, and they only share the TT.
+struct SearchThread;
+
+// Everything one engine instance owns. Searches of different instances share
+// nothing, so they can run side by side in one process.
+struct ChessSimulator::EngineState {
+    explicit EngineState(int hashMb = DEFAULT_HASH_MB) : tt(hashMb) {}
+
+    Options options;
+    std::atomic<bool> stop{false};
+    TimeManager time;
+    TranspositionTable tt;
+    OpeningBook book;
+    std::mt19937_64 bookRandom{std::random_device{}()};
+
+    std::vector<std::unique_ptr<SearchThread>> threads;
+    std::vector<std::string> lastPrincipalVariation;
+    uint64_t lastSearchNodes = 0;
+    std::mutex progressMutex;
+    MoveInfo progress;
+    std::function<void(const MoveInfo&)> infoCallback;
+};
 
-    return bestScore;
-}
+struct SearchThread {
+    SearchThread(EngineState& engine, int id) : engine(engine), id(id) {}
+
+    EngineState& engine;
+    int id;
+    chess::Board board;
+    EvalState evalStack[MAX_PLY + 1] = {};
+    int evalPly = 0;
+    std::vector<PawnEntry> pawnHash = std::vector<PawnEntry>(PAWN_HASH_SIZE);
+    chess::Move killerMoves[MAX_PLY][2] = {};
+    int historyHeuristic[2][64][64] = {};
+    // The reply that refuted a move, by that move's piece and target square.
+    chess::Move counterMoves[12][64] = {};
+    // Cutoff statistics for captures, by moving piece, target and victim type.
+    int captureHistory[12][64][6] = {};
+    // The move made at each ply and the piece that made it.
+    chess::Move moveStack[MAX_PLY] = {};
+    int pieceStack[MAX_PLY] = {};
+    // The moves generated at each ply, here rather than in the recursive
+    // frames so a deep line costs no native stack; the WASM stack is small.
+    chess::Movelist moveLists[MAX_PLY];
+    // Moves that failed to cut off at each ply, penalised once another move does.
+    chess::Move quietsTried[MAX_PLY][MAX_QUIETS_TRIED];
+    chess::Move capturesTried[MAX_PLY][MAX_CAPTURES_TRIED];
+    // Keys of every position since the game's start, root at rootIndex.
+    std::vector<uint64_t> positionKeys;
+    int rootIndex = 0;
+    int lastNullIndex = 0;
+
+    // Triangular PV table: row ply holds the line found below that ply.
+    chess::Move pvTable[MAX_PLY][MAX_PLY] = {};
+    int pvLength[MAX_PLY] = {};
+    chess::Move previousPV[MAX_PLY] = {};
+    int previousPVLength = 0;
+    bool followPV = false;
+
+    chess::Move bestMove;
+    chess::Move rootBest;
+    int completedDepth = 0;
+    int rootScore = 0;
+    uint64_t nodes = 0;
+    uint64_t nextTimeCheck = 0;
+    // nodes lives outside so the node counter stays cheap; this only holds
+    // the CHESS_STAT counters and, on the main thread, the iterations.
+    SearchStats stats;
+
+    bool shouldStop();
+    void setPosition(const chess::Board& root, const std::vector<uint64_t>& history);
+    void doMove(chess::Move move);
+    void undoMove(chess::Move move);
+    void doNullMove();
+    void undoNullMove();
+    bool isRepetition() const;
+
+    void ageHeuristics();
+    int& historyEntry(chess::Move move);
+    int& captureHistoryEntry(chess::Move move);
+    chess::Move counterMove(int ply) const;
+
+    int evaluatePawnStructure();
+    int evaluate();
+
+    int scoreMove(chess::Move move, int ply);
+    void scoreMoves(chess::Movelist& moves, int ply);
+    void orderMoves(chess::Movelist& moves, int ply);
+    int quiescence(int alpha, int beta, int ply);
+    void updatePV(int ply, chess::Move move);
+    int alphaBeta(int depth, int alpha, int beta, int ply, bool allowNull = true);
+    int searchRoot(chess::Movelist& moves, int depth, int alpha, int beta);
+    void publishProgress();
+    void iterativeDeepening(chess::Movelist moves);
+};
 
-std::string ChessSimulator::Move(std::string fen, int timeLimitMs)
+// Selection step over pre-scored moves: swap the best remaining move into
+// place, so a cutoff early in the list never pays for sorting the rest.
+inline chess::Move pickMove(chess::Movelist& moves, int index)
 {
-    chess::Board board(fen);
+    int best = index;
+    for (int i = index + 1; i < int(moves.size()); ++i)
+    {
+        if (moves[i].score() > moves[best].score())
+            best = i;
+    }
 
-    chess::Movelist moves;
-    chess::movegen::legalmoves(moves, board);
+    std::swap(moves[index], moves[best]);
+    return moves[index];
+}
 
-    if (moves.empty())
-        return "";
+// Hands out moves in stages: the hash move, then captures, then quiets (where
+// killers sort first). A cutoff on the hash move skips move generation and a
+// cutoff on a capture never generates or sorts the quiet moves.
+class MovePicker {
+public:
+    MovePicker(SearchThread& thread, chess::Move ttMove, int ply)
+        : thread(thread), ttMove(ttMove), ply(ply), moves(thread.moveLists[ply]) {}
 
-    searchStart = std::chrono::high_resolution_clock::now();
-    timeLimitMsGlobal = timeLimitMs;
-    clearTT();
-    chess::Move bestMove = moves[0];
+    chess::Move next();
 
-    for (int depth = 1; depth <= MAX_DEPTH; depth++)
-    {
-        if (outOfTime())
-            break;
+private:
+    enum Stage { TT_MOVE, GEN_CAPTURES, CAPTURES, GEN_QUIETS, QUIETS, DONE };
 
-        orderMoves(moves, board, 0);
+    bool isPlausible(chess::Move move) const;
 
-        int alpha = -INF;
-        int beta = INF;
-        int bestScore = -INF;
-        bool firstMove = true;
+    SearchThread& thread;
+    chess::Move ttMove;
+    int ply;
+    Stage stage = TT_MOVE;
+    chess::Movelist& moves;
+    int index = 0;
+};
 
-        for (auto move : moves)
-        {
-            board.makeMove(move);
+// The TT entry was verified against the full key, so its move comes from this
+// very position; this only guards against a corrupted entry reaching makeMove.
+bool MovePicker::isPlausible(chess::Move move) const
+{
+    const chess::Board& board = thread.board;
+    auto piece = board.at(move.from());
+
+    if (piece == chess::Piece::underlying::NONE || piece.color() != board.sideToMove())
+        return false;
 
-            int score;
+    auto target = board.at(move.to());
+    if (move.typeOf() == chess::Move::CASTLING)
+        return target.type() == chess::PieceType::ROOK && target.color() == board.sideToMove();
 
-            if (firstMove)
+    return target == chess::Piece::underlying::NONE || target.color() != board.sideToMove();
+}
+
+chess::Move MovePicker::next()
+{
+    switch (stage)
+    {
+        case TT_MOVE:
+            stage = GEN_CAPTURES;
+            if (ttMove != chess::Move(chess::Move::NO_MOVE) && isPlausible(ttMove))
+                return ttMove;
+            ttMove = chess::Move(chess::Move::NO_MOVE);
+            [[fallthrough]];
+
+        case GEN_CAPTURES:
+            chess::movegen::legalmoves<chess::movegen::MoveGenType::CAPTURE>(moves, thread.board);
+            thread.scoreMoves(moves, ply);
+            index = 0;
+            stage = CAPTURES;
+            [[fallthrough]];
+
+        case CAPTURES:
+            while (index < int(moves.size()))
             {
-                score = -alphaBeta(board, depth - 1, -beta, -alpha, 1);
-                firstMove = false;
+                chess::Move move = pickMove(moves, index++);
+                if (move != ttMove)
+                    return move;
             }
-            else
-            {
-                score = -alphaBeta(board, depth - 1, -alpha - 1, -alpha, 1);
+            [[fallthrough]];
 
-                if (score > alpha)
-                    score = -alphaBeta(board, depth - 1, -beta, -alpha, 1);
+        case GEN_QUIETS:
+            chess::movegen::legalmoves<chess::movegen::MoveGenType::QUIET>(moves, thread.board);
+            thread.scoreMoves(moves, ply);
+            index = 0;
+            stage = QUIETS;
+            [[fallthrough]];
+
+        case QUIETS:
+            while (index < int(moves.size()))
+            {
+                chess::Move move = pickMove(moves, index++);
+                if (move != ttMove)
+                    return move;
             }
+            stage = DONE;
+            [[fallthrough]];
 
-            board.unmakeMove(move);
+        case DONE:
+            break;
+    }
 
-            if (outOfTime())
-                break;
+    return chess::Move(chess::Move::NO_MOVE);
+}
 
-            if (score > bestScore)
-            {
-                bestScore = score;
-                bestMove = move;
-            }
+void SearchThread::setPosition(const chess::Board& root, const std::vector<uint64_t>& history)
+{
+    initEvalTables();
+
+    board = root;
+    evalPly = 0;
+    evalStack[0] = computeEvalState(board);
+
+    positionKeys.reserve(history.size() + MAX_PLY + 1);
+    positionKeys.assign(history.begin(), history.end());
+    positionKeys.push_back(board.hash());
+    rootIndex = int(history.size());
+    lastNullIndex = 0;
+
+    ageHeuristics();
+    nodes = 0;
+    nextTimeCheck = TIME_CHECK_NODES;
+    stats = SearchStats();
+    stats.iterations.reserve(MAX_DEPTH);
+}
 
-            if (score > alpha)
-                alpha = score;
-        }
+// Only the main thread reads the clock, and only every TIME_CHECK_NODES
+// nodes; the helpers just watch the shared stop flag.
+inline bool SearchThread::shouldStop()
+{
+    if (id == 0 && nodes >= nextTimeCheck)
+    {
+        nextTimeCheck = nodes + TIME_CHECK_NODES;
+        if (engine.time.hardLimitReached())
+            engine.stop.store(true, std::memory_order_relaxed);
     }
 
-    return chess::uci::moveToUci(bestMove);
+    return engine.stop.load(std::memory_order_relaxed);
+}
+
+inline void SearchThread::doMove(chess::Move move)
+{
+    evalStack[evalPly + 1] = evalStack[evalPly];
+    updateEvalState(evalStack[evalPly + 1], board, move);
+    ++evalPly;
+    board.makeMove(move);
+    positionKeys.push_back(board.hash());
+}
+
+inline void SearchThread::undoMove(chess::Move move)
+{
+    positionKeys.pop_back();
+    board.unmakeMove(move);
+    --evalPly;
+}
+
+inline void SearchThread::doNullMove()
+{
+    evalStack[evalPly + 1] = evalStack[evalPly];
+    ++evalPly;
+    board.makeNullMove();
+    positionKeys.push_back(board.hash());
+}
+
+inline void SearchThread::undoNullMove()
+{
+    positionKeys.pop_back();
+    board.unmakeNullMove();
+    --evalPly;
+}
+
+// Nothing before the last capture, pawn move or null move can recur, and only
+// every second ply has the same side to move. A repeat inside the search is
+// scored as a draw straight away; one from the game must have happened twice.
+bool SearchThread::isRepetition() const
+{
+    int current = int(positionKeys.size()) - 1;
+    int limit = std::max({ 0, current - int(board.halfMoveClock()), lastNullIndex });
+    int count = 0;
+
+    for (int i = current - 4; i >= limit; i -= 2)
+    {
+        if (positionKeys[i] == positionKeys[current] && (i > rootIndex || ++count >= 2))
+            return true;
+    }
+
+    return false;
+}
+
+int SearchThread::evaluatePawnStructure()
+{
+    uint64_t key = evalStack[evalPly].pawnKey;
+    PawnEntry& entry = pawnHash[key & (PAWN_HASH_SIZE - 1)];
+
+    if (entry.key != key)
+    {
+        entry.key = key;
+        entry.score = pawnStructureScore(board.pieces(chess::PieceType::PAWN, chess::Color::WHITE).getBits(),
+                                         board.pieces(chess::PieceType::PAWN, chess::Color::BLACK).getBits());
+    }
+
+    return entry.score;
+}
+
+int SearchThread::evaluate()
+{
+    int score = evaluateIncremental(evalStack[evalPly]);
+
+    score += evaluatePawnStructure();
+    score += engine.options.exactMobility ? evaluateMobilityExact(board) : evaluateMobility(board);
+    score += evaluateKingSafety(board);
+    return (board.sideToMove() == chess::Color::WHITE) ? score : -score;
+}
+
+// Ordering scores are stored in the move's 16-bit score field:
+// captures > killers > counter-move > history. Capture history only shifts
+// captures among themselves.
+static constexpr int CAPTURE_SCORE = 24000;
+static constexpr int KILLER1_SCORE = 22000;
+static constexpr int KILLER2_SCORE = 21000;
+static constexpr int COUNTER_SCORE = 20500;
+static constexpr int HISTORY_MAX = 16384;
+static_assert(HISTORY_MAX < COUNTER_SCORE && CAPTURE_SCORE - 1000 - HISTORY_MAX / 32 > KILLER1_SCORE);
+
+// History gravity: a bonus moves an entry less the closer it already is to
+// the bound, so scores stay inside +-HISTORY_MAX however often they are hit.
+inline void updateHistory(int& entry, int bonus)
+{
+    entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
+
+inline bool isCaptureMove(const chess::Board& board, chess::Move move)
+{
+    return board.isCapture(move) || move.typeOf() == chess::Move::ENPASSANT;
+}
+
+// Between searches history keeps half its weight, so what was learned stays
+// useful without drowning out the new position, and the old killers go.
+void SearchThread::ageHeuristics()
+{
+    for (auto& side : historyHeuristic)
+        for (auto& from : side)
+            for (int& entry : from)
+                entry /= 2;
+
+    for (auto& piece : captureHistory)
+        for (auto& to : piece)
+            for (int& entry : to)
+                entry /= 2;
+
+    for (auto& killers : killerMoves)
+        killers[0] = killers[1] = chess::Move(chess::Move::NO_MOVE);
+}
+
+inline int& SearchThread::historyEntry(chess::Move move)
+{
+    int side = (board.sideToMove() == chess::Color::WHITE) ? 0 : 1;
+    return historyHeuristic[side][move.from().index()][move.to().index()];
+}
+
+inline int& SearchThread::captureHistoryEntry(chess::Move move)
+{
+    int piece = int(board.at(move.from()).internal());
+    int victim = move.typeOf() == chess::Move::ENPASSANT ? int(chess::PieceType::PAWN) : int(board.at(move.to()).type());
+    return captureHistory[piece][move.to().index()][victim];
+}
+
+inline chess::Move SearchThread::counterMove(int ply) const
+{
+    if (ply == 0 || moveStack[ply - 1] == chess::Move(chess::Move::NO_MOVE))
+        return chess::Move(chess::Move::NO_MOVE);
+    return counterMoves[pieceStack[ply - 1]][moveStack[ply - 1].to().index()];
+}
+
+int SearchThread::scoreMove(chess::Move move, int ply) {
+    if (isCaptureMove(board, move))
+        return CAPTURE_SCORE + captureScore(board, move) + captureHistoryEntry(move) / 32;
+
+    if (move == killerMoves[ply][0])
+        return KILLER1_SCORE;
+
+    if (move == killerMoves[ply][1])
+        return KILLER2_SCORE;
+
+    if (move == counterMove(ply))
+        return COUNTER_SCORE;
+
+    return historyEntry(move);
+}
+
+void SearchThread::scoreMoves(chess::Movelist& moves, int ply) {
+    for (auto& move : moves)
+        move.setScore(int16_t(scoreMove(move, ply)));
+}
+
+void SearchThread::orderMoves(chess::Movelist& moves, int ply) {
+    scoreMoves(moves, ply);
+    std::sort(moves.begin(), moves.end(),
+        [](const chess::Move& a, const chess::Move& b) {
+            return a.score() > b.score();
+        });
+}
+
+static constexpr int DELTA_MARGIN = 200;
+
+int SearchThread::quiescence(int alpha, int beta, int ply) {
+    ++nodes;
+    CHESS_STAT(++stats.qnodes);
+    int standPat = evaluate();
+
+    if (ply >= MAX_PLY - 1)
+        return standPat;
+
+    if (standPat >= beta)
+        return beta;
+
+    if (alpha < standPat)
+        alpha = standPat;
+
+    chess::Movelist& moves = moveLists[ply];
+    chess::movegen::legalmoves<chess::movegen::MoveGenType::CAPTURE>(moves, board);
+
+    for (auto& move : moves)
+        move.setScore(int16_t(captureScore(board, move)));
+
+    for (int i = 0; i < int(moves.size()); ++i) {
+        chess::Move move = pickMove(moves, i);
+
+        if (move.typeOf() != chess::Move::PROMOTION)
+        {
+            // Delta pruning: not even winning the piece for free reaches alpha.
+            if (standPat + capturedValue(board, move) + DELTA_MARGIN <= alpha)
+                continue;
+
+            // Losing exchanges are left to the full-width search.
+            if (see(board, move) < 0)
+                continue;
+        }
+
+        doMove(move);
+        int score = -quiescence(-beta, -alpha, ply + 1);
+        undoMove(move);
+
+        if (score >= beta)
+            return beta;
+
+        if (score > alpha)
+            alpha = score;
+    }
+
+    return alpha;
+}
+
+inline void SearchThread::updatePV(int ply, chess::Move move)
+{
+    pvTable[ply][ply] = move;
+    for (int i = ply + 1; i < pvLength[ply + 1]; ++i)
+        pvTable[ply][i] = pvTable[ply + 1][i];
+    pvLength[ply] = pvLength[ply + 1];
+}
+
+// Selectivity margins, all in centipawns.
+static constexpr int REVERSE_FUTILITY_MARGIN = 120;
+static constexpr int FUTILITY_MARGIN[3] = { 0, 200, 350 };
+
+// Late move reduction by depth and move number, log-log shaped.
+static int lateMoveReduction(int depth, int moveCount)
+{
+    static const auto table = [] {
+        std::array<std::array<int, 64>, 64> t{};
+        for (int d = 1; d < 64; ++d)
+            for (int m = 1; m < 64; ++m)
+                t[d][m] = int(0.75 + std::log(d) * std::log(m) / 2.25);
+        return t;
+    }();
+
+    return table[std::min(depth, 63)][std::min(moveCount, 63)];
+}
+
+// Bare kings, a single minor piece, or only bishops all on one square colour.
+static bool isInsufficientMaterial(const chess::Board& board)
+{
+    using chess::PieceType;
+    constexpr uint64_t DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+
+    if ((board.pieces(PieceType::PAWN) | board.pieces(PieceType::ROOK) | board.pieces(PieceType::QUEEN)).getBits())
+        return false;
+
+    uint64_t knights = board.pieces(PieceType::KNIGHT).getBits();
+    uint64_t bishops = board.pieces(PieceType::BISHOP).getBits();
+
+    if (std::popcount(knights | bishops) <= 1)
+        return true;
+
+    return !knights && (!(bishops & DARK_SQUARES) || !(bishops & ~DARK_SQUARES));
+}
+
+static bool hasNonPawnMaterial(const chess::Board& board, chess::Color color)
+{
+    auto pawnsAndKing = board.pieces(chess::PieceType::PAWN, color) | board.pieces(chess::PieceType::KING, color);
+    return (board.us(color) & ~pawnsAndKing).getBits() != 0;
+}
+
+int SearchThread::alphaBeta(int depth, int alpha, int beta, int ply, bool allowNull)
+{
+    pvLength[ply] = ply;
+
+    // An aborted search unwinds with a dummy score; every caller checks the
+    // stop flag before using a child's result, so it never reaches the TT.
+    ++nodes;
+    if (shouldStop())
+        return 0;
+
+    if (ply >= MAX_PLY - 1)
+        return evaluate();
+
+    uint64_t hash = board.hash();
+
+    if (isRepetition() || isInsufficientMaterial(board))
+        return 0;
+
+    // Mate still beats the fifty-move rule, but only a side in check can be
+    // mated, so the rare in-check case alone pays for move generation.
+    if (board.halfMoveClock() >= 100)
+    {
+        if (!board.inCheck())
+            return 0;
+
+        chess::Movelist& evasions = moveLists[ply];
+        chess::movegen::legalmoves(evasions, board);
+        return evasions.empty() ? -MATE_SCORE + ply : 0;
+    }
+
+    if (depth <= 0)
+        return quiescence(alpha, beta, ply);
+
+    TTEntry tt;
+    chess::Move ttMove = chess::Move(chess::Move::NO_MOVE);
+    bool ttHit = engine.tt.probe(hash, tt);
+    CHESS_STAT(++stats.ttProbes);
+
+    if (ttHit)
+    {
+        ttMove = tt.move;
+        CHESS_STAT(++stats.ttHits);
+    }
+
+    if (ttHit && tt.depth >= depth)
+    {
+        tt.score = scoreFromTT(tt.score, ply);
+
+        if (tt.type == EXACT)
+        {
+            CHESS_STAT(++stats.ttCutoffs);
+            return tt.score;
+        }
+
+        else if (tt.type == LOWERBOUND)
+            alpha = std::max(alpha, tt.score);
+
+        else if (tt.type == UPPERBOUND)
+            beta = std::min(beta, tt.score);
+
+        if (alpha >= beta)
+        {
+            CHESS_STAT(++stats.ttCutoffs);
+            return tt.score;
+        }
+    }
+
+#ifdef CHESS_SYZYGY
+    // A table result is exact, so it ends the search here like a TT hit.
+    if (ply > 0 && board.halfMoveClock() == 0 && inTablebases(board))
+    {
+        unsigned wdl = probeWdl(board);
+        if (wdl != TB_RESULT_FAILED)
+        {
+            CHESS_STAT(++stats.tbHits);
+            int score = wdlScore(wdl, ply);
+            engine.tt.store(hash, std::min(depth + 6, MAX_DEPTH), scoreToTT(score, ply), EXACT, chess::Move(chess::Move::NO_MOVE));
+            return score;
+        }
+    }
+#endif
+
+    bool pvNode = beta - alpha > 1;
+    bool inCheck = board.inCheck();
+    bool canPrune = !pvNode && !inCheck;
+    int staticEval = canPrune ? evaluate() : 0;
+
+    // Reverse futility: far enough above beta that a shallow search is not
+    // going to bring the score back down.
+    if (engine.options.futilityPruning && canPrune && depth <= 3 && std::abs(beta) < MATE_IN_MAX
+        && staticEval - REVERSE_FUTILITY_MARGIN * depth >= beta)
+        return staticEval;
+
+    // Null move: if passing still fails high, a real move will too. Skipped
+    // with only pawns left, where zugzwang makes passing a poor guess.
+    if (engine.options.nullMovePruning && canPrune && allowNull && depth >= 3 && staticEval >= beta
+        && hasNonPawnMaterial(board, board.sideToMove()))
+    {
+        int reduction = depth >= 6 ? 3 : 2;
+
+        followPV = false;
+        int savedNullIndex = lastNullIndex;
+        moveStack[ply] = chess::Move(chess::Move::NO_MOVE);
+        doNullMove();
+        lastNullIndex = int(positionKeys.size()) - 1;
+        int score = -alphaBeta(depth - 1 - reduction, -beta, -beta + 1, ply + 1, false);
+        undoNullMove();
+        lastNullIndex = savedNullIndex;
+
+        if (engine.stop.load(std::memory_order_relaxed))
+            return 0;
+
+        if (score >= beta)
+            return score >= MATE_IN_MAX ? beta : score;
+    }
+
+    // Futility: near the leaves, quiet moves cannot lift a score this far
+    // below alpha.
+    bool futile = engine.options.futilityPruning && canPrune && depth <= 2 && std::abs(alpha) < MATE_IN_MAX
+        && staticEval + FUTILITY_MARGIN[depth] <= alpha;
+
+    // While still on the previous iteration's PV its move goes first, even if
+    // the TT slot that held it has since been overwritten.
+    chess::Move pvMove = chess::Move(chess::Move::NO_MOVE);
+    if (followPV)
+    {
+        if (ply < previousPVLength)
+            pvMove = previousPV[ply];
+        else
+            followPV = false;
+    }
+
+    MovePicker picker(*this, pvMove != chess::Move(chess::Move::NO_MOVE) ? pvMove : ttMove, ply);
+
+    int originalAlpha = alpha;
+    int bestScore = -INF;
+    chess::Move bestMoveHere = chess::Move(chess::Move::NO_MOVE);
+    int moveCount = 0;
+
+    int quietCount = 0;
+    int captureCount = 0;
+
+    for (chess::Move move = picker.next(); move != chess::Move(chess::Move::NO_MOVE); move = picker.next())
+    {
+        if (move != pvMove)
+            followPV = false;
+
+        bool capture = isCaptureMove(board, move);
+        bool quiet = !capture && move.typeOf() != chess::Move::PROMOTION;
+        bool killer = move == killerMoves[ply][0] || move == killerMoves[ply][1];
+        ++moveCount;
+
+        moveStack[ply] = move;
+        pieceStack[ply] = int(board.at(move.from()).internal());
+        doMove(move);
+
+        bool givesCheck = board.inCheck();
+
+        if (futile && moveCount > 1 && quiet && !givesCheck)
+        {
+            undoMove(move);
+            bestScore = std::max(bestScore, staticEval + FUTILITY_MARGIN[depth]);
+            continue;
+        }
+
+        int score;
+
+        if (moveCount == 1)
+        {
+            score = -alphaBeta(depth - 1, -beta, -alpha, ply + 1);
+        }
+        else
+        {
+            // Late quiet moves are searched shallower first, less so when
+            // history says they have cut off before.
+            int reduction = 0;
+            if (engine.options.lateMoveReductions && depth >= 3 && moveCount > 3 && quiet && !killer && !inCheck && !givesCheck)
+            {
+                reduction = lateMoveReduction(depth, moveCount);
+                if (move.score() > 0)
+                    --reduction;
+                if (pvNode)
+                    --reduction;
+                reduction = std::clamp(reduction, 0, depth - 2);
+            }
+
+            score = -alphaBeta(depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+
+            if (reduction > 0 && score > alpha)
+                score = -alphaBeta(depth - 1, -alpha - 1, -alpha, ply + 1);
+
+            if (score > alpha && score < beta) {
+                score = -alphaBeta(depth - 1, -beta, -alpha, ply + 1);
+            }
+        }
+
+        undoMove(move);
+
+        if (engine.stop.load(std::memory_order_relaxed))
+            return 0;
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestMoveHere = move;
+        }
+
+        if (score > alpha)
+        {
+            alpha = score;
+            updatePV(ply, move);
+        }
+
+        if (alpha >= beta)
+        {
+            CHESS_STAT(++(moveCount == 1 ? stats.failHighFirst : stats.failHighLater));
+            int bonus = std::min(16 * depth * depth, 1600);
+
+            if (quiet)
+            {
+                if (move != killerMoves[ply][0])
+                {
+                    killerMoves[ply][1] = killerMoves[ply][0];
+                    killerMoves[ply][0] = move;
+                }
+
+                if (ply > 0 && moveStack[ply - 1] != chess::Move(chess::Move::NO_MOVE))
+                    counterMoves[pieceStack[ply - 1]][moveStack[ply - 1].to().index()] = move;
+
+                updateHistory(historyEntry(move), bonus);
+                for (int i = 0; i < quietCount; ++i)
+                    updateHistory(historyEntry(quietsTried[ply][i]), -bonus);
+            }
+            else if (capture)
+            {
+                updateHistory(captureHistoryEntry(move), bonus);
+            }
+
+            for (int i = 0; i < captureCount; ++i)
+                updateHistory(captureHistoryEntry(capturesTried[ply][i]), -bonus);
+
+            break;
+        }
+
+        if (quiet && quietCount < MAX_QUIETS_TRIED)
+            quietsTried[ply][quietCount++] = move;
+        else if (capture && captureCount < MAX_CAPTURES_TRIED)
+            capturesTried[ply][captureCount++] = move;
+    }
+
+    if (moveCount == 0)
+        return inCheck ? -MATE_SCORE + ply : 0;
+
+    NodeType type;
+    if (bestScore <= originalAlpha)
+        type = UPPERBOUND;
+    else if (bestScore >= beta)
+        type = LOWERBOUND;
+    else
+        type = EXACT;
+
+    engine.tt.store(hash, depth, scoreToTT(bestScore, ply), type, bestMoveHere);
+
+    return bestScore;
+}
+
+// Searches the root moves in list order inside [alpha, beta]. rootBest and
+// the root PV are only set by a move that raised alpha, so a fail low or an
+// abort before the first move finished leaves rootBest empty.
+int SearchThread::searchRoot(chess::Movelist& moves, int depth, int alpha, int beta)
+{
+    int bestScore = -INF;
+    rootBest = chess::Move(chess::Move::NO_MOVE);
+    pvLength[0] = 0;
+
+    for (int i = 0; i < int(moves.size()); ++i)
+    {
+        chess::Move move = moves[i];
+        followPV = i == 0 && previousPVLength > 0 && move == previousPV[0];
+
+        moveStack[0] = move;
+        pieceStack[0] = int(board.at(move.from()).internal());
+        doMove(move);
+
+        int score;
+
+        if (i == 0)
+        {
+            score = -alphaBeta(depth - 1, -beta, -alpha, 1);
+        }
+        else
+        {
+            score = -alphaBeta(depth - 1, -alpha - 1, -alpha, 1);
+
+            if (score > alpha && score < beta)
+                score = -alphaBeta(depth - 1, -beta, -alpha, 1);
+        }
+
+        undoMove(move);
+
+        if (engine.stop.load(std::memory_order_relaxed))
+            break;
+
+        if (score > bestScore)
+            bestScore = score;
+
+        if (score > alpha)
+        {
+            alpha = score;
+            rootBest = move;
+            updatePV(0, move);
+        }
+
+        if (alpha >= beta)
+            break;
+    }
+
+    return bestScore;
+}
+
+// Mate distance in moves from a mate score; positive when the side to move mates.
+static int mateInMoves(int score)
+{
+    if (std::abs(score) < MATE_IN_MAX)
+        return 0;
+    return score > 0 ? (MATE_SCORE - score + 1) / 2 : -(MATE_SCORE + score) / 2;
+}
+
+// Copies the latest completed iteration out for SearchProgress(); iterations
+// are few enough that the lock and the string conversions do not show.
+void SearchThread::publishProgress()
+{
+    MoveInfo info;
+    info.move = chess::uci::moveToUci(bestMove);
+    info.score = rootScore;
+    info.mate = mateInMoves(rootScore);
+    for (int i = 0; i < previousPVLength; ++i)
+        info.pv.push_back(chess::uci::moveToUci(previousPV[i]));
+    info.stats = stats;
+    info.stats.nodes = nodes;
+    info.stats.depth = completedDepth;
+    info.stats.timeMs = engine.time.searchTimeMs();
+
+    if (engine.infoCallback)
+        engine.infoCallback(info);
+
+    std::lock_guard<std::mutex> lock(engine.progressMutex);
+    engine.progress = std::move(info);
+}
+
+void SearchThread::iterativeDeepening(chess::Movelist moves)
+{
+    bestMove = moves[0];
+    previousPVLength = 0;
+    completedDepth = 0;
+    rootScore = 0;
+    int score = 0;
+    int stableIterations = 0;
+    uint64_t iterationStartNodes = nodes;
+    int64_t iterationStartMs = engine.time.searchTimeMs();
+
+    // Odd helpers start one ply deeper so the threads spread over
+    // neighbouring depths instead of all searching the same tree.
+    int maxDepth = engine.options.maxDepth > 0 ? std::min(engine.options.maxDepth, MAX_DEPTH) : MAX_DEPTH;
+
+    for (int depth = 1 + id % 2; depth <= maxDepth; depth++)
+    {
+        if (engine.stop.load(std::memory_order_relaxed))
+            break;
+
+        // Helpers run until they are told to stop; the main thread decides.
+        if (id == 0 && completedDepth > 0 && !engine.time.shouldStartIteration(stableIterations))
+            break;
+
+        chess::Move previousBest = bestMove;
+
+        orderMoves(moves, 0);
+
+        // Aspiration: the score rarely moves far between iterations, so start
+        // with a narrow window around the last one and widen it on a fail.
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -INF;
+        int beta = INF;
+
+        if (depth >= ASPIRATION_DEPTH && completedDepth > 0)
+        {
+            alpha = std::max(-INF, score - delta);
+            beta = std::min(INF, score + delta);
+        }
+
+        while (true)
+        {
+            // The current best goes first so that a partial search which
+            // finishes it already has a trustworthy result.
+            auto first = std::find(moves.begin(), moves.end(), bestMove);
+            if (first != moves.end())
+                std::rotate(moves.begin(), first, first + 1);
+
+            int result = searchRoot(moves, depth, alpha, beta);
+
+            // A move that raised alpha is exact or a proven fail high, even
+            // when the search was aborted right after it.
+            if (rootBest != chess::Move(chess::Move::NO_MOVE))
+            {
+                bestMove = rootBest;
+                previousPVLength = pvLength[0];
+                std::copy(pvTable[0], pvTable[0] + pvLength[0], previousPV);
+            }
+
+            if (engine.stop.load(std::memory_order_relaxed))
+                break;
+
+            if (result <= alpha)
+            {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(-INF, result - delta);
+            }
+            else if (result >= beta)
+            {
+                beta = std::min(INF, result + delta);
+            }
+            else
+            {
+                score = result;
+                break;
+            }
+
+            delta *= 2;
+        }
+
+        if (engine.stop.load(std::memory_order_relaxed))
+            break;
+
+        completedDepth = depth;
+        rootScore = score;
+        stableIterations = (bestMove == previousBest) ? stableIterations + 1 : 0;
+
+        if (id == 0)
+        {
+            IterationInfo info;
+            info.depth = depth;
+            info.score = score;
+            info.nodes = nodes - iterationStartNodes;
+            info.timeMs = engine.time.searchTimeMs() - iterationStartMs;
+            if (!stats.iterations.empty() && stats.iterations.back().nodes > 0)
+                info.branchingFactor = double(info.nodes) / double(stats.iterations.back().nodes);
+            stats.iterations.push_back(info);
+
+            iterationStartNodes = nodes;
+            iterationStartMs += info.timeMs;
+            publishProgress();
+        }
+
+        // A mate that fits inside the searched depth will not change.
+        if (id == 0 && std::abs(score) >= MATE_IN_MAX && MATE_SCORE - std::abs(score) <= depth)
+            break;
+    }
+}
+
+static int maxSearchThreads()
+{
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    return 1;
+#elif defined(CHESS_THREAD_POOL_SIZE)
+    // the calling thread blocks until the search ends, so helpers can only
+    // come from the preallocated worker pool
+    return std::min(MAX_THREADS, CHESS_THREAD_POOL_SIZE + 1);
+#else
+    return MAX_THREADS;
+#endif
+}
+
+static MoveInfo searchPosition(EngineState& engine, const chess::Board& board, const std::vector<uint64_t>& history, int timeLimitMs, int threads)
+{
+    chess::Movelist moves;
+    chess::movegen::legalmoves(moves, board);
+
+    engine.lastPrincipalVariation.clear();
+    engine.lastSearchNodes = 0;
+    {
+        std::lock_guard<std::mutex> lock(engine.progressMutex);
+        engine.progress = MoveInfo();
+    }
+    if (moves.empty())
+        return {};
+
+    if (engine.book.loaded())
+    {
+        chess::Move bookMove = engine.book.probe(board, moves, engine.bookRandom);
+        if (bookMove != chess::Move(chess::Move::NO_MOVE))
+        {
+            MoveInfo info;
+            info.move = chess::uci::moveToUci(bookMove);
+            info.bookMove = true;
+            info.pv = {info.move};
+            engine.lastPrincipalVariation = info.pv;
+
+            std::lock_guard<std::mutex> lock(engine.progressMutex);
+            engine.progress = info;
+            return info;
+        }
+    }
+
+#ifdef CHESS_SYZYGY
+    if (inTablebases(board))
+    {
+        int score = 0;
+        chess::Move tableMove = probeRoot(board, moves, score);
+        if (tableMove != chess::Move(chess::Move::NO_MOVE))
+        {
+            MoveInfo info;
+            info.move = chess::uci::moveToUci(tableMove);
+            info.score = score;
+            info.pv = {info.move};
+            info.stats.tbHits = 1;
+            engine.lastPrincipalVariation = info.pv;
+
+            std::lock_guard<std::mutex> lock(engine.progressMutex);
+            engine.progress = info;
+            return info;
+        }
+    }
+#endif
+
+    engine.time.init(timeLimitMs);
+    engine.tt.newSearch();
+
+    auto& searchThreads = engine.threads;
+    threads = std::clamp(threads, 1, maxSearchThreads());
+    while (int(searchThreads.size()) < threads)
+        searchThreads.push_back(std::make_unique<SearchThread>(engine, int(searchThreads.size())));
+
+    for (int i = 0; i < threads; ++i)
+        searchThreads[i]->setPosition(board, history);
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threads; ++i)
+        helpers.emplace_back([&searchThreads, i, moves] { searchThreads[i]->iterativeDeepening(moves); });
+
+    searchThreads[0]->iterativeDeepening(moves);
+
+    engine.stop = true;
+    for (auto& helper : helpers)
+        helper.join();
+
+    // Prefer the main thread unless a helper finished a deeper iteration.
+    SearchThread* best = searchThreads[0].get();
+    for (int i = 1; i < threads; ++i)
+    {
+        if (searchThreads[i]->completedDepth > best->completedDepth)
+            best = searchThreads[i].get();
+    }
+
+    MoveInfo info;
+    info.stats = std::move(searchThreads[0]->stats);
+    info.stats.depth = best->completedDepth;
+    info.stats.timeMs = engine.time.searchTimeMs();
+    for (int i = 0; i < threads; ++i)
+    {
+        info.stats.nodes += searchThreads[i]->nodes;
+        if (i == 0)
+            continue;
+        const SearchStats& helper = searchThreads[i]->stats;
+        info.stats.qnodes += helper.qnodes;
+        info.stats.ttProbes += helper.ttProbes;
+        info.stats.ttHits += helper.ttHits;
+        info.stats.ttCutoffs += helper.ttCutoffs;
+        info.stats.failHighFirst += helper.failHighFirst;
+        info.stats.failHighLater += helper.failHighLater;
+        info.stats.tbHits += helper.tbHits;
+    }
+    engine.lastSearchNodes = info.stats.nodes;
+
+    engine.lastPrincipalVariation.clear();
+    for (int i = 0; i < best->previousPVLength; ++i)
+        engine.lastPrincipalVariation.push_back(chess::uci::moveToUci(best->previousPV[i]));
+
+    info.move = chess::uci::moveToUci(best->bestMove);
+    info.score = best->rootScore;
+    info.mate = mateInMoves(best->rootScore);
+    info.pv = engine.lastPrincipalVariation;
+
+    std::lock_guard<std::mutex> lock(engine.progressMutex);
+    engine.progress = info;
+    return info;
+}
+
+// Finds the legal move written as uci, or NO_MOVE. The text is compared with
+// each legal move instead of being decoded, so a short or malformed token
+// cannot read past its end.
+static chess::Move findLegalMove(const chess::Board& board, const std::string& uci)
+{
+    if (uci.size() < 4 || uci.size() > 5)
+        return chess::Move(chess::Move::NO_MOVE);
+
+    chess::Movelist legal;
+    chess::movegen::legalmoves(legal, board);
+    for (const auto& move : legal)
+        if (chess::uci::moveToUci(move) == uci)
+            return move;
+    return chess::Move(chess::Move::NO_MOVE);
+}
+
+Engine::Engine(int hashMb) : state(std::make_unique<EngineState>(hashMb)) {}
+
+Engine::~Engine() = default;
+
+// The stop flag is cleared on entry, so a Stop() made at any point of the
+// call, even while the history is replayed, ends its search.
+MoveInfo Engine::MoveWithInfo(std::string fen, int timeLimitMs, int threads)
+{
+    state->stop = false;
+    return searchPosition(*state, chess::Board(fen), {}, timeLimitMs, threads);
+}
+
+MoveInfo Engine::MoveWithInfo(std::string fen, const std::vector<std::string>& moves, int timeLimitMs, int threads)
+{
+    state->stop = false;
+    chess::Board board(fen);
+    std::vector<uint64_t> history;
+
+    for (const auto& uci : moves)
+    {
+        chess::Move move = findLegalMove(board, uci);
+        if (move == chess::Move(chess::Move::NO_MOVE))
+        {
+            state->lastPrincipalVariation.clear();
+            return {};
+        }
+
+        history.push_back(board.hash());
+        board.makeMove(move);
+    }
+
+    return searchPosition(*state, board, history, timeLimitMs, threads);
+}
+
+std::string Engine::Move(std::string fen, int timeLimitMs, int threads)
+{
+    return MoveWithInfo(std::move(fen), timeLimitMs, threads).move;
+}
+
+std::string Engine::Move(std::string fen, const std::vector<std::string>& moves, int timeLimitMs, int threads)
+{
+    return MoveWithInfo(std::move(fen), moves, timeLimitMs, threads).move;
+}
+
+void Engine::Stop()
+{
+    state->stop.store(true, std::memory_order_relaxed);
+}
+
+void Engine::SetTimeLimit(int timeLimitMs)
+{
+    state->time.restart(timeLimitMs);
+}
+
+void Engine::SetInfoCallback(std::function<void(const MoveInfo&)> callback)
+{
+    state->infoCallback = std::move(callback);
+}
+
+MoveInfo Engine::SearchProgress()
+{
+    std::lock_guard<std::mutex> lock(state->progressMutex);
+    return state->progress;
+}
+
+std::vector<std::string> Engine::PrincipalVariation() const
+{
+    return state->lastPrincipalVariation;
+}
+
+uint64_t Engine::SearchedNodes() const
+{
+    return state->lastSearchNodes;
+}
+
+void Engine::NewGame()
+{
+    state->tt.clear();
+    state->tt.resetGeneration();
+    state->threads.clear();
+}
+
+void Engine::SetHashSize(int megabytes)
+{
+    state->tt.resize(megabytes);
+}
+
+bool Engine::SetBook(const std::string& path)
+{
+    if (path.empty())
+    {
+        state->book.close();
+        return true;
+    }
+    return state->book.open(path);
+}
+
+void Engine::SetOptions(const Options& newOptions)
+{
+    state->options = newOptions;
+}
+
+const Options& Engine::GetOptions() const
+{
+    return state->options;
+}
+
+bool ChessSimulator::AnalyzeBatch(const std::function<bool(std::string&)>& nextFen,
+                                  const std::function<void(const std::string&, const MoveInfo&)>& onResult,
+                                  const BatchOptions& batch)
+{
+    std::mutex inputMutex;
+    std::mutex outputMutex;
+
+    auto work = [&](Engine& engine) {
+        std::string fen;
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(inputMutex);
+                if (!nextFen(fen))
+                    return;
+            }
+
+            MoveInfo info = engine.MoveWithInfo(fen, batch.timeLimitMs);
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            onResult(fen, info);
+        }
+    };
+
+    // the calling thread's engine is set up first, so an unreadable book
+    // fails the batch before any helper starts
+    Engine engine(batch.hashMb);
+    engine.SetOptions(batch.options);
+    if (!engine.SetBook(batch.bookPath))
+        return false;
+
+    int workers = std::clamp(batch.workers, 1, maxSearchThreads());
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < workers; ++i)
+        helpers.emplace_back([&] {
+            Engine helperEngine(batch.hashMb);
+            helperEngine.SetOptions(batch.options);
+            helperEngine.SetBook(batch.bookPath);
+            work(helperEngine);
+        });
+
+    work(engine);
+    for (auto& helper : helpers)
+        helper.join();
+    return true;
+}
+
+// The free functions drive one process-wide instance.
+static Engine& defaultEngine()
+{
+    static Engine engine;
+    return engine;
+}
+
+MoveInfo ChessSimulator::MoveWithInfo(std::string fen, int timeLimitMs, int threads)
+{
+    return defaultEngine().MoveWithInfo(std::move(fen), timeLimitMs, threads);
+}
+
+MoveInfo ChessSimulator::MoveWithInfo(std::string fen, const std::vector<std::string>& moves, int timeLimitMs, int threads)
+{
+    return defaultEngine().MoveWithInfo(std::move(fen), moves, timeLimitMs, threads);
+}
+
+std::string ChessSimulator::Move(std::string fen, int timeLimitMs, int threads)
+{
+    return defaultEngine().Move(std::move(fen), timeLimitMs, threads);
+}
+
+std::string ChessSimulator::Move(std::string fen, const std::vector<std::string>& moves, int timeLimitMs, int threads)
+{
+    return defaultEngine().Move(std::move(fen), moves, timeLimitMs, threads);
+}
+
+void ChessSimulator::Stop()
+{
+    defaultEngine().Stop();
+}
+
+void ChessSimulator::SetTimeLimit(int timeLimitMs)
+{
+    defaultEngine().SetTimeLimit(timeLimitMs);
+}
+
+void ChessSimulator::SetInfoCallback(std::function<void(const MoveInfo&)> callback)
+{
+    defaultEngine().SetInfoCallback(std::move(callback));
+}
+
+MoveInfo ChessSimulator::SearchProgress()
+{
+    return defaultEngine().SearchProgress();
+}
+
+std::vector<std::string> ChessSimulator::PrincipalVariation()
+{
+    return defaultEngine().PrincipalVariation();
+}
+
+uint64_t ChessSimulator::SearchedNodes()
+{
+    return defaultEngine().SearchedNodes();
+}
+
+void ChessSimulator::NewGame()
+{
+    defaultEngine().NewGame();
+}
+
+void ChessSimulator::SetHashSize(int megabytes)
+{
+    defaultEngine().SetHashSize(megabytes);
+}
+
+bool ChessSimulator::SetBook(const std::string& path)
+{
+    return defaultEngine().SetBook(path);
+}
+
+bool ChessSimulator::SetSyzygyPath(const std::string& path)
+{
+#ifdef CHESS_SYZYGY
+    syzygyPieces = 0;
+    if (path.empty())
+    {
+        tb_free();
+        return true;
+    }
+    if (!tb_init(path.c_str()))
+        return false;
+    syzygyPieces = int(TB_LARGEST);
+    return TB_LARGEST > 0;
+#else
+    return path.empty();
+#endif
+}
+
+void ChessSimulator::SetOptions(const Options& newOptions)
+{
+    defaultEngine().SetOptions(newOptions);
+}
+
+const Options& ChessSimulator::GetOptions()
+{
+    return defaultEngine().GetOptions();
 }
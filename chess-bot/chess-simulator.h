@@ -1,13 +1,316 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace ChessSimulator {
+/// Transposition table size used unless SetHashSize() says otherwise
+constexpr int DEFAULT_HASH_MB = 64;
+/// Deepest iterative deepening iteration; larger depth limits are capped to it
+constexpr int MAX_DEPTH = 100;
+
+/**
+ * @brief Evaluation and search switches, mainly for A/B testing
+ */
+struct Options {
+    /// Count legal moves for mobility (exact, slow) instead of attack bitboards
+    bool exactMobility = false;
+    /// Null-move pruning
+    bool nullMovePruning = true;
+    /// Late move reductions for quiet moves
+    bool lateMoveReductions = true;
+    /// Reverse futility and futility pruning near the leaves
+    bool futilityPruning = true;
+    /// Iterative deepening depth limit, at most MAX_DEPTH; 0 searches as deep as time allows
+    int maxDepth = 0;
+};
+
+/**
+ * @brief One completed iterative deepening iteration of the main thread
+ */
+struct IterationInfo {
+    int depth = 0;
+    /// Score in centipawns from the side to move's point of view
+    int score = 0;
+    /// Nodes searched by this iteration alone
+    uint64_t nodes = 0;
+    /// Time spent on this iteration alone
+    int64_t timeMs = 0;
+    /// Nodes of this iteration over nodes of the previous one; 0 for the first
+    double branchingFactor = 0.0;
+};
+
+/**
+ * @brief Search counters of one Move() call, summed over all threads
+ *
+ * The fine-grained counters are only kept in builds with CHESS_SEARCH_STATS
+ * and read 0 otherwise; nodes, depth, time and iterations are always filled in.
+ */
+struct SearchStats {
+    uint64_t nodes = 0;
+    /// Quiescence nodes, also counted in nodes
+    uint64_t qnodes = 0;
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;
+    /// Hits deep enough to return without searching
+    uint64_t ttCutoffs = 0;
+    /// Beta cutoffs by the first move searched, a measure of move ordering
+    uint64_t failHighFirst = 0;
+    uint64_t failHighLater = 0;
+    /// Positions answered by the Syzygy tablebases
+    uint64_t tbHits = 0;
+    /// Deepest completed iteration of the thread whose move was played
+    int depth = 0;
+    int64_t timeMs = 0;
+    std::vector<IterationInfo> iterations;
+};
+
+/**
+ * @brief A Move() result together with what the search knows about it
+ */
+struct MoveInfo {
+    /// The move as UCI, empty if there is none
+    std::string move;
+    /// Score in centipawns from the side to move's point of view
+    int score = 0;
+    /// Moves to mate, negative when getting mated; 0 if no mate was found
+    int mate = 0;
+    std::vector<std::string> pv;
+    SearchStats stats;
+    /// Taken from the opening book without a search; score and stats are then empty
+    bool bookMove = false;
+};
+
+/**
+ * @brief Settings for AnalyzeBatch()
+ */
+struct BatchOptions {
+    /// Positions searched at the same time, each by its own single-threaded engine
+    int workers = 1;
+    int timeLimitMs = 1000;
+    /// TT size of every worker's engine
+    int hashMb = 16;
+    /// Search options of every worker, including the depth limit
+    Options options;
+    /// Polyglot book every worker plays from, as with SetBook(); empty for none
+    std::string bookPath;
+};
+
+struct EngineState;
+
+/**
+ * @brief An independent engine: its own TT, heuristics, options and search threads
+ *
+ * Instances share no state, so several can search at the same time, e.g. one
+ * per game in a match runner. The free functions below drive a default
+ * instance and behave the same as the methods of the same name. One instance
+ * must not run two searches at once. Every per-ply buffer of the search is
+ * allocated with the engine's search threads, so searching the tree itself
+ * allocates no memory.
+ */
+class Engine {
+public:
+    /**
+     * @param hashMb Transposition table size in MB, allocated here
+     */
+    explicit Engine(int hashMb = DEFAULT_HASH_MB);
+    ~Engine();
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    std::string Move(std::string fen, int timeLimitMs = 10000, int threads = 1);
+    std::string Move(std::string fen, const std::vector<std::string>& moves, int timeLimitMs = 10000, int threads = 1);
+    MoveInfo MoveWithInfo(std::string fen, int timeLimitMs = 10000, int threads = 1);
+    MoveInfo MoveWithInfo(std::string fen, const std::vector<std::string>& moves, int timeLimitMs = 10000, int threads = 1);
+
+    void Stop();
+    void SetTimeLimit(int timeLimitMs);
+    void SetInfoCallback(std::function<void(const MoveInfo&)> callback);
+    MoveInfo SearchProgress();
+
+    std::vector<std::string> PrincipalVariation() const;
+    uint64_t SearchedNodes() const;
+
+    void NewGame();
+    void SetHashSize(int megabytes);
+    bool SetBook(const std::string& path);
+    void SetOptions(const Options& options);
+    const Options& GetOptions() const;
+
+private:
+    std::unique_ptr<EngineState> state;
+};
+
+/**
+ * @brief Replace the options used by subsequent searches
+ *
+ * @param options The new options
+ */
+void SetOptions(const Options& options);
+
+/**
+ * @brief The options currently in use
+ */
+const Options& GetOptions();
+
+/**
+ * @brief Set the transposition table size
+ *
+ * The table is reallocated at once, empty, and rounded down to a power of
+ * two. Defaults to DEFAULT_HASH_MB. Must not be called while a search runs.
+ *
+ * @param megabytes The table size in MB
+ */
+void SetHashSize(int megabytes);
+
+/**
+ * @brief Play from a Polyglot opening book while it has the position
+ *
+ * Move() then answers book positions at once, choosing among the book moves
+ * at random in proportion to their weights, and only searches once the game
+ * leaves the book. Must not be called while a search runs.
+ *
+ * @param path The .bin book file; an empty path unloads the book
+ * @return bool Whether a book is now loaded, or true for an empty path
+ */
+bool SetBook(const std::string& path);
+
+/**
+ * @brief Probe Syzygy endgame tablebases
+ *
+ * With tablebases, a root position they cover is answered by DTZ without a
+ * search, and positions inside the search are scored by WDL. Files are only
+ * mapped once a probe needs them. The tablebases are shared by every Engine
+ * in the process, and this must not be called while any of them searches.
+ * Engines may search at the same time: WDL probes run in parallel, while the
+ * root DTZ probe is not thread-safe in Fathom and is serialised.
+ * Builds without CHESS_SYZYGY have no tablebase support.
+ *
+ * @param path Directories holding .rtbw and .rtbz files, separated by ':' (';' on Windows); empty turns probing off
+ * @return bool Whether tablebases were found, or true for an empty path
+ */
+bool SetSyzygyPath(const std::string& path);
+
+/**
+ * @brief Forget everything learned in the current game
+ *
+ * Search results are kept between Move() calls; call this before starting
+ * an unrelated game or position.
+ */
+void NewGame();
+
 /**
  * @brief Move a piece on the board
  *
  * @param fen The board as FEN
  * @param timeLimitMs The time limit for the move in milliseconds
+ * @param threads Number of search threads (lazy SMP); ignored in single-threaded WASM builds
  * @return std::string The move as UCI
  */
-std::string Move(std::string fen, int timeLimitMs = 10000);
-} // namespace ChessSimulator
\ No newline at end of file
+std::string Move(std::string fen, int timeLimitMs = 10000, int threads = 1);
+
+/**
+ * @brief Move a piece on the board, knowing how the game got there
+ *
+ * Positions reached by the moves count towards threefold repetition.
+ *
+ * @param fen The board as FEN before the first of the moves
+ * @param moves The moves played since, as UCI
+ * @param timeLimitMs The time limit for the move in milliseconds
+ * @param threads Number of search threads (lazy SMP); ignored in single-threaded WASM builds
+ * @return std::string The move as UCI, or an empty string if a move is malformed or illegal
+ */
+std::string Move(std::string fen, const std::vector<std::string>& moves, int timeLimitMs = 10000, int threads = 1);
+
+/**
+ * @brief Move() with the score, principal variation and search statistics
+ *
+ * @param fen The board as FEN
+ * @param timeLimitMs The time limit for the move in milliseconds
+ * @param threads Number of search threads (lazy SMP); ignored in single-threaded WASM builds
+ * @return MoveInfo The move and how it was found
+ */
+MoveInfo MoveWithInfo(std::string fen, int timeLimitMs = 10000, int threads = 1);
+
+/**
+ * @brief Move() with game history, plus the score, principal variation and search statistics
+ *
+ * @param fen The board as FEN before the first of the moves
+ * @param moves The moves played since, as UCI
+ * @param timeLimitMs The time limit for the move in milliseconds
+ * @param threads Number of search threads (lazy SMP); ignored in single-threaded WASM builds
+ * @return MoveInfo The move and how it was found; the move is empty if one of the moves is malformed or illegal
+ */
+MoveInfo MoveWithInfo(std::string fen, const std::vector<std::string>& moves, int timeLimitMs = 10000, int threads = 1);
+
+/**
+ * @brief Search many unrelated positions in parallel
+ *
+ * Workers pull one FEN at a time from nextFen and report each result as soon
+ * as it is found, so memory stays bounded however long the input is. Both
+ * callbacks are serialised; results arrive in completion order. Every worker
+ * owns its engine, so this does not touch the default instance.
+ *
+ * @param nextFen Stores the next FEN and returns true, or returns false at the end of the input
+ * @param onResult Receives each FEN with its result; the move is empty if the position has none
+ * @param options Worker count, time limit, hash size, search options and book
+ * @return bool False, without searching anything, if the book cannot be read
+ */
+bool AnalyzeBatch(const std::function<bool(std::string&)>& nextFen,
+                  const std::function<void(const std::string&, const MoveInfo&)>& onResult,
+                  const BatchOptions& options = {});
+
+/**
+ * @brief Make the running Move() return its best move so far
+ *
+ * Safe to call from any thread. Once a Move*() call has been entered, a stop
+ * is never lost: it ends that call's search, even if it comes before the
+ * search proper has begun. A stop made before the call is entered is lost.
+ * A caller that may be racing the start of its own call can repeat the stop
+ * from the info callback, which only runs once the call has begun.
+ */
+void Stop();
+
+/**
+ * @brief Give the running Move() a new time limit, counted from now
+ *
+ * Meant for pondering: search with a very long limit on the opponent's time
+ * and set the real one once the expected move is played. Safe to call from
+ * any thread.
+ *
+ * @param timeLimitMs The new time limit in milliseconds
+ */
+void SetTimeLimit(int timeLimitMs);
+
+/**
+ * @brief Receive the progress of a running search
+ *
+ * The callback runs on the main search thread after every completed
+ * iteration, with the same data SearchProgress() returns. Pass an empty
+ * function to remove it. Must not be called while a search runs.
+ */
+void SetInfoCallback(std::function<void(const MoveInfo&)> callback);
+
+/**
+ * @brief The state of the running search after its last completed iteration
+ *
+ * Safe to call from any thread while Move() runs. Until the search ends the
+ * nodes are those of the main thread only; afterwards this is the full
+ * result of the last search.
+ */
+MoveInfo SearchProgress();
+
+/**
+ * @brief The principal variation behind the last Move() result
+ *
+ * @return std::vector<std::string> The expected line as UCI moves, starting with the move played
+ */
+std::vector<std::string> PrincipalVariation();
+
+/**
+ * @brief Nodes searched by all threads during the last Move() call
+ */
+uint64_t SearchedNodes();
+} // namespace ChessSimulator
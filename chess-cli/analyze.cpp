@@ -0,0 +1,231 @@
+#include "analyze.h"
+#include "chess.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#define CHESS_CLI_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Hands out the input one line at a time, skipping blank lines.
+class LineSource {
+public:
+    ~LineSource();
+
+    bool open(const std::string& path);
+    bool next(std::string& line);
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+    bool mapped = false;
+    // an empty file: neither mapped nor open, and not stdin either
+    bool exhausted = false;
+    FILE* file = nullptr;
+};
+
+LineSource::~LineSource() {
+#ifdef CHESS_CLI_MMAP
+    if (mapped)
+        munmap(const_cast<char*>(data), size);
+#endif
+    if (file)
+        std::fclose(file);
+}
+
+bool LineSource::open(const std::string& path) {
+    if (path.empty() || path == "-")
+        return true;
+
+#ifdef CHESS_CLI_MMAP
+    // mapped, the file is paged in as the workers get to it
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info {};
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) {
+            madvise(view, size_t(info.st_size), MADV_SEQUENTIAL);
+            data = static_cast<const char*>(view);
+            size = size_t(info.st_size);
+            mapped = true;
+        }
+    }
+    ::close(fd);
+    exhausted = info.st_size == 0;
+    if (mapped || exhausted)
+        return true;
+#endif
+
+    file = std::fopen(path.c_str(), "r");
+    return file != nullptr;
+}
+
+bool LineSource::next(std::string& line) {
+    while (true) {
+        if (exhausted) {
+            return false;
+        } else if (mapped) {
+            if (offset >= size)
+                return false;
+            const char* start = data + offset;
+            const char* end = static_cast<const char*>(std::memchr(start, '\n', size - offset));
+            size_t length = end ? size_t(end - start) : size - offset;
+            line.assign(start, length);
+            offset += length + 1;
+        } else if (file) {
+            line.clear();
+            int c;
+            while ((c = std::fgetc(file)) != EOF && c != '\n')
+                line += char(c);
+            if (c == EOF && line.empty())
+                return false;
+        } else if (!std::getline(std::cin, line)) {
+            return false;
+        }
+
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.find_first_not_of(" \t") != std::string::npos)
+            return true;
+    }
+}
+
+bool isNumber(const std::string& field) {
+    return !field.empty() && field.size() <= 6 &&
+           std::all_of(field.begin(), field.end(), [](unsigned char c) { return std::isdigit(c); });
+}
+
+// Checks one input line before it reaches the board parser, which trusts its
+// input, and stores it with single spaces between the fields. Needs the six
+// FEN fields, eight ranks of eight squares with one king per side, castling
+// rights backed by the king and rook on their squares, and the side not to
+// move out of check.
+bool normalizeFen(const std::string& line, std::string& fen) {
+    std::istringstream in(line);
+    std::vector<std::string> fields;
+    for (std::string field; in >> field;)
+        fields.push_back(field);
+    if (fields.size() != 6)
+        return false;
+
+    // squares in FEN order: a8 first, h1 last
+    char squares[64];
+    std::fill(std::begin(squares), std::end(squares), ' ');
+    int rank = 0;
+    int file = 0;
+    int kings[2] = {0, 0};
+    for (char c : fields[0]) {
+        if (c == '/') {
+            if (file != 8)
+                return false;
+            ++rank;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else if (c != '\0' && std::strchr("pnbrqkPNBRQK", c)) {
+            // no pawns on the first or last rank
+            if ((c == 'p' || c == 'P') && (rank == 0 || rank == 7))
+                return false;
+            if (c == 'K' || c == 'k')
+                ++kings[c == 'k'];
+            if (rank < 8 && file < 8)
+                squares[rank * 8 + file] = c;
+            ++file;
+        } else {
+            return false;
+        }
+        if (file > 8 || rank > 7)
+            return false;
+    }
+    if (rank != 7 || file != 8 || kings[0] != 1 || kings[1] != 1)
+        return false;
+
+    if (fields[1] != "w" && fields[1] != "b")
+        return false;
+    if (fields[2] != "-") {
+        if (fields[2].size() > 4 || fields[2].find_first_not_of("KQkq") != std::string::npos)
+            return false;
+        // king on e1/e8 and the rook in its corner
+        for (char right : fields[2]) {
+            bool black = right == 'k' || right == 'q';
+            int row = black ? 0 : 7;
+            int rookFile = right == 'K' || right == 'k' ? 7 : 0;
+            if (squares[row * 8 + 4] != (black ? 'k' : 'K') || squares[row * 8 + rookFile] != (black ? 'r' : 'R'))
+                return false;
+        }
+    }
+    // the en passant square is behind a pawn that just moved two squares
+    char epRank = fields[1] == "w" ? '6' : '3';
+    if (fields[3] != "-" && (fields[3].size() != 2 || fields[3][0] < 'a' || fields[3][0] > 'h' || fields[3][1] != epRank))
+        return false;
+    if (!isNumber(fields[4]) || !isNumber(fields[5]))
+        return false;
+
+    fen = fields[0];
+    for (size_t i = 1; i < fields.size(); ++i)
+        fen += " " + fields[i];
+
+    // the side that just moved may not have left its king attacked
+    chess::Board board(fen);
+    return !board.isAttacked(board.kingSq(~board.sideToMove()), board.sideToMove());
+}
+
+std::string formatScore(const ChessSimulator::MoveInfo& info) {
+    if (info.mate != 0)
+        return "#" + std::to_string(info.mate);
+    return std::to_string(info.score);
+}
+
+} // namespace
+
+int runAnalyze(const std::string& path, const ChessSimulator::BatchOptions& batch) {
+    LineSource input;
+    if (!input.open(path)) {
+        std::cerr << "cannot read " << path << std::endl;
+        return 1;
+    }
+
+    // error rows are written while reading, so they share the output lock
+    std::mutex outputMutex;
+    auto nextFen = [&](std::string& fen) {
+        std::string line;
+        while (input.next(line)) {
+            if (normalizeFen(line, fen))
+                return true;
+            line.erase(0, line.find_first_not_of(" \t"));
+            line.erase(line.find_last_not_of(" \t") + 1);
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << line << ",,error\n" << std::flush;
+        }
+        return false;
+    };
+    auto onResult = [&](const std::string& fen, const ChessSimulator::MoveInfo& info) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << fen << "," << (info.move.empty() ? "0000" : info.move) << "," << formatScore(info) << ","
+                  << info.stats.depth << "," << info.stats.nodes << "\n"
+                  << std::flush;
+    };
+
+    if (!ChessSimulator::AnalyzeBatch(nextFen, onResult, batch)) {
+        std::cerr << "cannot read book " << batch.bookPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "chess-simulator.h"
+#include <string>
+
+/**
+ * @brief Analyse one FEN per input line and stream the results to stdout
+ *
+ * Reads from a memory-mapped file, or from stdin when path is empty or "-".
+ * Prints "fen,bestmove,score,depth,nodes" per position in completion order;
+ * the score is in centipawns, or "#N" for a mate in N. A line that is not a
+ * valid FEN is reported as "line,,error" and skipped.
+ *
+ * @param path The input file
+ * @param batch Workers, time limit, per-worker hash size, search options and book
+ * @return int The process exit code
+ */
+int runAnalyze(const std::string& path, const ChessSimulator::BatchOptions& batch);
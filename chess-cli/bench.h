@@ -0,0 +1,15 @@
+#pragma once
+
+static constexpr int DEFAULT_BENCH_DEPTH = 8;
+
+/**
+ * @brief Search every position of the reference suite to a fixed depth
+ *
+ * Prints per-position results to stderr and the totals, NPS and a node-count
+ * signature to stdout. Single-threaded and from a clean state, so the
+ * signature only changes when the search itself does.
+ *
+ * @param depth The iterative deepening depth for every position
+ * @return int The process exit code
+ */
+int runBench(int depth);
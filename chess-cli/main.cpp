@@ -1,10 +1,157 @@
+#include "analyze.h"
+#include "bench.h"
+#include "uci.h"
 #include "chess-simulator.h"
 #include "chess.hpp"
+#include <charconv>
+#include <climits>
+#include <cstdio>
 #include <string>
 
-int main() {
+static void printUsage() {
+    std::fprintf(stderr,
+                 "usage: chesscli [options] < fen     search one position read from stdin\n"
+                 "       chesscli uci [options]       speak UCI on stdin and stdout\n"
+                 "       chesscli analyze [file] [options]\n"
+                 "                                    analyse one FEN per line, from stdin without a file\n"
+                 "       chesscli bench [depth]       search the reference suite, depth 1-%d\n"
+                 "options: --depth N (1-%d) --threads N --hash MB --movetime MS --book FILE\n"
+                 "         --syzygy PATH --stats --exact-mobility --no-null-move --no-lmr --no-futility\n",
+                 ChessSimulator::MAX_DEPTH, ChessSimulator::MAX_DEPTH);
+}
+
+// Parses a whole argument as an int in [min, max].
+static bool parseNumber(const char* text, int min, int max, int& value) {
+    const char* end = text + std::char_traits<char>::length(text);
+    int number = 0;
+    auto [last, error] = std::from_chars(text, end, number);
+    if (error != std::errc() || last != end || number < min || number > max)
+        return false;
+    value = number;
+    return true;
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * double(part) / double(whole) : 0.0;
+}
+
+// Search statistics go to stderr so stdout stays a single move.
+static void printStats(const ChessSimulator::MoveInfo& info) {
+    const auto& stats = info.stats;
+    std::fprintf(stderr, "score %d", info.score);
+    if (info.mate != 0)
+        std::fprintf(stderr, " (mate %d)", info.mate);
+    std::fprintf(stderr, ", depth %d, %lld ms, %llu nodes (%llu qnodes)\n", stats.depth,
+                 (long long)stats.timeMs, (unsigned long long)stats.nodes, (unsigned long long)stats.qnodes);
+
+    std::string pv;
+    for (const auto& move : info.pv)
+        pv += " " + move;
+    std::fprintf(stderr, "pv%s\n", pv.c_str());
+
+    std::fprintf(stderr, "tt: %llu probes, %.1f%% hits, %llu cutoffs\n", (unsigned long long)stats.ttProbes,
+                 percent(stats.ttHits, stats.ttProbes), (unsigned long long)stats.ttCutoffs);
+    std::fprintf(stderr, "fail high: %.1f%% on the first move (%llu of %llu)\n",
+                 percent(stats.failHighFirst, stats.failHighFirst + stats.failHighLater),
+                 (unsigned long long)stats.failHighFirst, (unsigned long long)(stats.failHighFirst + stats.failHighLater));
+    if (stats.tbHits > 0)
+        std::fprintf(stderr, "tablebase hits: %llu\n", (unsigned long long)stats.tbHits);
+
+    std::fprintf(stderr, "%5s %7s %12s %8s %6s\n", "depth", "score", "nodes", "ms", "ebf");
+    for (const auto& iteration : stats.iterations)
+        std::fprintf(stderr, "%5d %7d %12llu %8lld %6.2f\n", iteration.depth, iteration.score,
+                     (unsigned long long)iteration.nodes, (long long)iteration.timeMs, iteration.branchingFactor);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        int depth = DEFAULT_BENCH_DEPTH;
+        if (argc > 2 && !parseNumber(argv[2], 1, ChessSimulator::MAX_DEPTH, depth)) {
+            printUsage();
+            return 1;
+        }
+        return runBench(depth);
+    }
+
+    ChessSimulator::Options options;
+    int threads = 1;
+    int hashMb = ChessSimulator::DEFAULT_HASH_MB;
+    int moveTimeMs = 10000;
+    bool moveTimeSet = false;
+    bool showStats = false;
+    std::string bookPath;
+    std::string syzygyPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--exact-mobility")
+            options.exactMobility = true;
+        else if (arg == "--no-null-move")
+            options.nullMovePruning = false;
+        else if (arg == "--no-lmr")
+            options.lateMoveReductions = false;
+        else if (arg == "--no-futility")
+            options.futilityPruning = false;
+        else if (arg == "--depth" || arg == "--threads" || arg == "--hash" || arg == "--movetime") {
+            int* value = &moveTimeMs;
+            if (arg == "--depth")
+                value = &options.maxDepth;
+            else if (arg == "--threads")
+                value = &threads;
+            else if (arg == "--hash")
+                value = &hashMb;
+            int max = arg == "--depth" ? ChessSimulator::MAX_DEPTH : INT_MAX;
+            if (i + 1 >= argc || !parseNumber(argv[++i], 1, max, *value)) {
+                if (arg == "--depth")
+                    std::fprintf(stderr, "--depth needs a number from 1 to %d\n", max);
+                else
+                    std::fprintf(stderr, "%s needs a positive number\n", arg.c_str());
+                printUsage();
+                return 1;
+            }
+            moveTimeSet = moveTimeSet || arg == "--movetime";
+        }
+        else if (arg == "--book" && i + 1 < argc)
+            bookPath = argv[++i];
+        else if (arg == "--syzygy" && i + 1 < argc)
+            syzygyPath = argv[++i];
+        else if (arg == "--stats")
+            showStats = true;
+    }
+    // the tablebases are shared by every engine, the batch workers' included
+    if (!ChessSimulator::SetSyzygyPath(syzygyPath))
+        std::fprintf(stderr, "no tablebases in %s\n", syzygyPath.c_str());
+
+    // analyze [file]: --threads sets the worker count; each worker searches single-threaded
+    // with its own engine, so the default one is never set up
+    if (argc > 1 && std::string(argv[1]) == "analyze") {
+        ChessSimulator::BatchOptions batch;
+        batch.workers = threads;
+        batch.options = options;
+        batch.hashMb = hashMb;
+        batch.bookPath = bookPath;
+        // a depth limit alone should decide where the search stops
+        batch.timeLimitMs = moveTimeSet || options.maxDepth == 0 ? moveTimeMs : 24 * 60 * 60 * 1000;
+        std::string path = argc > 2 && argv[2][0] != '-' ? argv[2] : "";
+        return runAnalyze(path, batch);
+    }
+
+    ChessSimulator::SetOptions(options);
+    ChessSimulator::SetHashSize(hashMb);
+    if (!ChessSimulator::SetBook(bookPath))
+        std::fprintf(stderr, "cannot read book %s, searching every move\n", bookPath.c_str());
+
+    if (argc > 1 && std::string(argv[1]) == "uci")
+        return runUci(threads);
+
+    // engine runners start the engine without arguments and open with "uci"
     std::string fen;
     getline(std::cin, fen);
-    auto move = ChessSimulator::Move(fen);
-    std::cout << move << std::endl;
-}
\ No newline at end of file
+    if (fen == "uci")
+        return runUci(threads, fen);
+    auto info = ChessSimulator::MoveWithInfo(fen, moveTimeMs, threads);
+    std::cout << info.move << std::endl;
+    if (showStats && info.bookMove)
+        std::fprintf(stderr, "book move\n");
+    else if (showStats)
+        printStats(info);
+}
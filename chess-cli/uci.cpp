@@ -0,0 +1,339 @@
+#include "uci.h"
+#include "chess-simulator.h"
+#include "chess.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// "forever" for infinite and ponder searches, which end on stop or ponderhit
+constexpr int INFINITE_MS = 24 * 60 * 60 * 1000;
+// assumed moves left when the GUI sends no movestogo
+constexpr int DEFAULT_MOVES_TO_GO = 30;
+// kept in hand for GUI and process latency
+constexpr int MOVE_OVERHEAD_MS = 50;
+// the ranges advertised for the spin options
+constexpr int MAX_HASH_MB = 65536;
+constexpr int MAX_THREADS = 64;
+
+struct GoLimits {
+    int timeMs[2] = {-1, -1};
+    int incMs[2] = {0, 0};
+    int movesToGo = 0;
+    int moveTimeMs = -1;
+    int depth = 0;
+    bool infinite = false;
+    bool ponder = false;
+};
+
+class UciSession {
+public:
+    explicit UciSession(int threads) : threads(std::max(1, threads)), baseOptions(ChessSimulator::GetOptions()) {}
+
+    int run(const std::string& firstCommand);
+
+private:
+    int threads;
+    ChessSimulator::Options baseOptions;
+    std::string fen = chess::constants::STARTPOS;
+    std::vector<std::string> moves;
+    chess::Color side = chess::Color::WHITE;
+
+    std::mutex outputMutex;
+    std::mutex stateMutex;
+    std::condition_variable released;
+    std::thread worker;
+    // infinite and ponder searches must not report a move before stop/ponderhit
+    bool holdResult = false;
+    int ponderBudgetMs = 0;
+    // SetTimeLimit() only reaches a search that has started; an early
+    // ponderhit is applied when the first iteration reports in
+    bool searchStarted = false;
+    bool ponderHitPending = false;
+    // likewise a stop sent before MoveWithInfo() is entered
+    bool stopPending = false;
+
+    bool handle(const std::string& line);
+    void send(const std::string& line);
+    void sendInfo(const ChessSimulator::MoveInfo& info);
+    void onIteration(const ChessSimulator::MoveInfo& info);
+    void setPosition(std::istringstream& in);
+    void setOption(std::istringstream& in);
+    void go(std::istringstream& in);
+    void ponderHit();
+    void stopSearch();
+    int budgetMs(const GoLimits& limits) const;
+};
+
+void UciSession::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+void UciSession::sendInfo(const ChessSimulator::MoveInfo& info) {
+    std::ostringstream line;
+    line << "info depth " << info.stats.depth;
+    if (info.mate != 0)
+        line << " score mate " << info.mate;
+    else
+        line << " score cp " << info.score;
+    line << " nodes " << info.stats.nodes << " time " << info.stats.timeMs
+         << " nps " << info.stats.nodes * 1000 / uint64_t(std::max<int64_t>(info.stats.timeMs, 1));
+    if (!info.pv.empty()) {
+        line << " pv";
+        for (const auto& move : info.pv)
+            line << " " << move;
+    }
+    send(line.str());
+}
+
+void UciSession::onIteration(const ChessSimulator::MoveInfo& info) {
+    sendInfo(info);
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (searchStarted)
+        return;
+    searchStarted = true;
+    if (ponderHitPending)
+        ChessSimulator::SetTimeLimit(ponderBudgetMs);
+    if (stopPending)
+        ChessSimulator::Stop();
+}
+
+void UciSession::setPosition(std::istringstream& in) {
+    std::string token;
+    in >> token;
+
+    std::string newFen;
+    if (token == "startpos") {
+        newFen = chess::constants::STARTPOS;
+        in >> token;
+    } else if (token == "fen") {
+        std::string field;
+        while (in >> field && field != "moves")
+            newFen += (newFen.empty() ? "" : " ") + field;
+        token = field;
+    } else {
+        send("info string unknown position " + token);
+        return;
+    }
+
+    std::vector<std::string> played;
+    if (token == "moves") {
+        std::string move;
+        while (in >> move)
+            played.push_back(move);
+    }
+
+    // replay the moves by matching them with the legal ones, so a bad token
+    // from the GUI leaves the previous position in place
+    chess::Board board(newFen);
+    for (const auto& uci : played) {
+        chess::Movelist legal;
+        chess::movegen::legalmoves(legal, board);
+        auto move = std::find_if(legal.begin(), legal.end(),
+                                 [&](const chess::Move& m) { return chess::uci::moveToUci(m) == uci; });
+        if (move == legal.end()) {
+            send("info string illegal move " + uci + ", position ignored");
+            return;
+        }
+        board.makeMove(*move);
+    }
+
+    fen = newFen;
+    moves = std::move(played);
+    side = board.sideToMove();
+}
+
+void UciSession::setOption(std::istringstream& in) {
+    std::string token, name, value;
+    in >> token;
+    while (in >> token && token != "value")
+        name += (name.empty() ? "" : " ") + token;
+    // the rest of the line, since a path may contain spaces
+    std::getline(in >> std::ws, value);
+
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+    if (name == "hash" || name == "threads") {
+        int number = 0;
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+        if (error != std::errc() || end != value.data() + value.size()) {
+            send("info string invalid value " + value + " for " + name);
+            return;
+        }
+        if (name == "hash")
+            ChessSimulator::SetHashSize(std::clamp(number, 1, MAX_HASH_MB));
+        else
+            threads = std::clamp(number, 1, MAX_THREADS);
+    } else if (name == "bookfile" && !ChessSimulator::SetBook(value == "<empty>" ? "" : value))
+        send("info string cannot read book " + value);
+    else if (name == "syzygypath" && !ChessSimulator::SetSyzygyPath(value == "<empty>" ? "" : value))
+        send("info string no tablebases in " + value);
+    // Ponder needs nothing here: the GUI decides when to send "go ponder"
+}
+
+int UciSession::budgetMs(const GoLimits& limits) const {
+    if (limits.moveTimeMs >= 0)
+        return std::max(1, limits.moveTimeMs);
+
+    int color = side == chess::Color::WHITE ? 0 : 1;
+    int timeMs = limits.timeMs[color];
+    if (timeMs < 0)
+        return INFINITE_MS;
+
+    int movesToGo = limits.movesToGo > 0 ? limits.movesToGo : DEFAULT_MOVES_TO_GO;
+    int budget = timeMs / movesToGo + limits.incMs[color] * 3 / 4;
+    return std::max(1, std::min(budget, timeMs - MOVE_OVERHEAD_MS));
+}
+
+void UciSession::go(std::istringstream& in) {
+    stopSearch();
+
+    GoLimits limits;
+    std::string token;
+    while (in >> token) {
+        if (token == "wtime")
+            in >> limits.timeMs[0];
+        else if (token == "btime")
+            in >> limits.timeMs[1];
+        else if (token == "winc")
+            in >> limits.incMs[0];
+        else if (token == "binc")
+            in >> limits.incMs[1];
+        else if (token == "movestogo")
+            in >> limits.movesToGo;
+        else if (token == "movetime")
+            in >> limits.moveTimeMs;
+        else if (token == "depth")
+            in >> limits.depth;
+        else if (token == "infinite")
+            limits.infinite = true;
+        else if (token == "ponder")
+            limits.ponder = true;
+    }
+
+    ChessSimulator::Options options = baseOptions;
+    if (limits.depth > 0)
+        options.maxDepth = limits.depth;
+    ChessSimulator::SetOptions(options);
+
+    int budget = budgetMs(limits);
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        holdResult = limits.infinite || limits.ponder;
+        ponderBudgetMs = budget;
+        searchStarted = false;
+        ponderHitPending = false;
+        stopPending = false;
+    }
+    // a ponder search runs on the opponent's clock until ponderhit sets the real limit
+    int timeLimitMs = (limits.infinite || limits.ponder || limits.depth > 0) ? INFINITE_MS : budget;
+
+    worker = std::thread([this, timeLimitMs, fen = fen, moves = moves, threads = threads] {
+        auto info = ChessSimulator::MoveWithInfo(fen, moves, timeLimitMs, threads);
+
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            released.wait(lock, [this] { return !holdResult; });
+        }
+
+        std::string line = "bestmove " + (info.move.empty() ? std::string("0000") : info.move);
+        if (info.pv.size() > 1)
+            line += " ponder " + info.pv[1];
+        send(line);
+    });
+}
+
+void UciSession::ponderHit() {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (!holdResult)
+        return;
+    holdResult = false;
+    if (searchStarted)
+        ChessSimulator::SetTimeLimit(ponderBudgetMs);
+    else
+        ponderHitPending = true;
+    released.notify_all();
+}
+
+void UciSession::stopSearch() {
+    if (!worker.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        holdResult = false;
+        stopPending = true;
+        released.notify_all();
+    }
+    ChessSimulator::Stop();
+    worker.join();
+}
+
+// Returns false once the session should end.
+bool UciSession::handle(const std::string& line) {
+    std::istringstream in(line);
+    std::string command;
+    in >> command;
+
+    if (command == "uci") {
+        send("id name chess-simulator");
+        send("id author gameguild");
+        send("option name Hash type spin default " + std::to_string(ChessSimulator::DEFAULT_HASH_MB) + " min 1 max " +
+             std::to_string(MAX_HASH_MB));
+        send("option name Threads type spin default " + std::to_string(threads) + " min 1 max " + std::to_string(MAX_THREADS));
+        send("option name Ponder type check default false");
+        send("option name BookFile type string default <empty>");
+        send("option name SyzygyPath type string default <empty>");
+        send("uciok");
+    } else if (command == "isready") {
+        send("readyok");
+    } else if (command == "setoption") {
+        stopSearch();
+        setOption(in);
+    } else if (command == "ucinewgame") {
+        stopSearch();
+        ChessSimulator::NewGame();
+    } else if (command == "position") {
+        stopSearch();
+        setPosition(in);
+    } else if (command == "go") {
+        go(in);
+    } else if (command == "ponderhit") {
+        ponderHit();
+    } else if (command == "stop") {
+        stopSearch();
+    } else if (command == "quit") {
+        return false;
+    }
+    return true;
+}
+
+int UciSession::run(const std::string& firstCommand) {
+    ChessSimulator::SetInfoCallback([this](const ChessSimulator::MoveInfo& info) { onIteration(info); });
+
+    bool running = firstCommand.empty() || handle(firstCommand);
+    std::string line;
+    while (running && std::getline(std::cin, line))
+        running = handle(line);
+
+    stopSearch();
+    ChessSimulator::SetInfoCallback({});
+    return 0;
+}
+
+} // namespace
+
+int runUci(int threads, const std::string& firstCommand) {
+    UciSession session(threads);
+    return session.run(firstCommand);
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+
+/**
+ * @brief Speak UCI on stdin/stdout until "quit" or end of input
+ *
+ * The engine state (TT, history) carries over between searches, so a GUI or
+ * match runner such as cutechess or fastchess only pays for startup once.
+ * Supports go with wtime/btime/winc/binc/movestogo, movetime, depth,
+ * infinite and ponder, plus stop and ponderhit.
+ *
+ * @param threads Default number of search threads, changed by setoption Threads
+ * @param firstCommand A command already read from stdin, handled before the rest
+ * @return int The process exit code
+ */
+int runUci(int threads, const std::string& firstCommand = "");
@@ -29,8 +29,11 @@ EM_JS(int, canvas_get_height, (), { return canvas.height; });
 #include "chess.hpp"
 
 #include "PieceSvg.h"
+#include "pgn.h"
 #include "magic_enum/magic_enum.hpp"
+#include <atomic>
 #include <chrono>
+#include <future>
 #include <map>
 #include <sstream>
 #include <vector>
@@ -47,17 +50,76 @@ std::chrono::nanoseconds timeSpentLastMove = std::chrono::milliseconds::zero();
 string gameResult;
 std::vector<std::string> movesDisplay;
 std::vector<std::string> movesUCI;
+ChessSimulator::MoveInfo lastMoveInfo;
+
+// the bot searches on a worker thread so the ui keeps rendering meanwhile
+std::future<ChessSimulator::MoveInfo> pendingSearch;
+std::chrono::high_resolution_clock::time_point searchStartTime;
+
+// a stop sent before the worker has entered MoveWithInfo() is lost, so the
+// info callback repeats it once the search reports in
+std::atomic<bool> stopRequested{false};
+
+bool searching() { return pendingSearch.valid(); }
+
+void stopSearch() {
+  stopRequested = true;
+  ChessSimulator::Stop();
+}
+
+void cancelSearch() {
+  if (!searching())
+    return;
+  stopSearch();
+  pendingSearch.get();
+}
+
 void reset(chess::Board &board) {
+  cancelSearch();
   board = chess::Board();
+  ChessSimulator::NewGame();
   simulationState = SimulationState::PAUSED;
   timeSpentOnMoves = std::chrono::nanoseconds::zero();
   timeSpentLastMove = std::chrono::milliseconds::zero();
   gameResult = "";
   movesDisplay.clear();
   movesUCI.clear();
+  lastMoveInfo = ChessSimulator::MoveInfo();
+}
+
+void applyMove(chess::Board &board, ChessSimulator::MoveInfo info) {
+  auto afterTime = std::chrono::high_resolution_clock::now();
+  std::string turn(magic_enum::enum_name(board.sideToMove().internal()));
+  // apply move
+  // remove \n if present
+  auto moveStr = info.move;
+  moveStr.erase(std::remove(moveStr.begin(), moveStr.end(), '\n'),
+                moveStr.end());
+  auto move = chess::uci::uciToMove(board, moveStr);
+  board.makeMove(move);
+
+  // update stats
+  timeSpentOnMoves += afterTime - searchStartTime;
+  timeSpentLastMove = afterTime - searchStartTime;
+  movesDisplay.push_back(
+      std::to_string(board.fullMoveNumber()) + " " + turn + ": " + moveStr
+  );
+
+  movesUCI.push_back(moveStr);
+  lastMoveInfo = std::move(info);
+}
+
+// applies the worker's move once it is done; called every frame
+void pollSearch(chess::Board &board) {
+  if (searching() && pendingSearch.wait_for(std::chrono::seconds(0)) ==
+                         std::future_status::ready)
+    applyMove(board, pendingSearch.get());
 }
 
 void move(chess::Board &board) {
+  if (searching())
+    return;
+
   if (board.isHalfMoveDraw()) {
     auto result = board.getHalfMoveDrawType();
     gameResult = std::string(magic_enum::enum_name(result.second)) + " " +
@@ -73,29 +135,35 @@ void move(chess::Board &board) {
     return;
   }
 
-  std::string turn(magic_enum::enum_name(board.sideToMove().internal()));
   // get stats
-  auto beforeTime = std::chrono::high_resolution_clock::now();
+  searchStartTime = std::chrono::high_resolution_clock::now();
 
   // run!
-  auto moveStr = ChessSimulator::Move(board.getFen(true));
-  // get stats
-  auto afterTime = std::chrono::high_resolution_clock::now();
-  // apply move
-  // remove \n if present
-  moveStr.erase(std::remove(moveStr.begin(), moveStr.end(), '\n'),
-                moveStr.end());
-  auto move = chess::uci::uciToMove(board, moveStr);
-  board.makeMove(move);
-
-  // update stats
-  timeSpentOnMoves += afterTime - beforeTime;
-  timeSpentLastMove = afterTime - beforeTime;
-  movesDisplay.push_back(
-      std::to_string(board.fullMoveNumber()) + " " + turn + ": " + moveStr
-  );
+  std::string fen = board.getFen(true);
+  stopRequested = false;
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  // no threads to hand the search to; ASYNCIFY keeps the page alive meanwhile
+  std::promise<ChessSimulator::MoveInfo> done;
+  done.set_value(ChessSimulator::MoveWithInfo(fen));
+  pendingSearch = done.get_future();
+#else
+  pendingSearch = std::async(std::launch::async,
+                             [fen] { return ChessSimulator::MoveWithInfo(fen); });
+#endif
+}
 
-  movesUCI.push_back(moveStr);
+void showSearchInfo(const ChessSimulator::MoveInfo &info) {
+  if (info.mate != 0)
+    ImGui::Text("Depth %d  mate %d", info.stats.depth, info.mate);
+  else
+    ImGui::Text("Depth %d  score %+.2f", info.stats.depth, info.score / 100.0);
+  ImGui::Text("Nodes %llu  %lldms", (unsigned long long)info.stats.nodes,
+              (long long)info.stats.timeMs);
+
+  std::string pv;
+  for (const auto &move : info.pv)
+    pv += move + " ";
+  ImGui::TextWrapped("PV: %s", pv.c_str());
 }
 
 struct Texture {
@@ -108,54 +176,6 @@ struct Texture {
       SDL_FreeSurface(surface);
   }
 };
-std::string GeneratePGN(const std::vector<std::string>& uciMoves,
-                        const std::string& result)
-{
-  chess::Board board;
-  std::ostringstream pgn;
-
-  // PGN headers
-  pgn << "[Event \"Self Play\"]\n";
-  pgn << "[Site \"Local\"]\n";
-  pgn << "[Result \"" << result << "\"]\n\n";
-
-  int moveNumber = 1;
-
-  for (size_t i = 0; i < uciMoves.size(); i++)
-  {
-    chess::Move move = chess::uci::uciToMove(board, uciMoves[i]);
-
-    if (board.sideToMove() == chess::Color::WHITE)
-    {
-      pgn << moveNumber << ". ";
-    }
-
-    std::string san = chess::uci::moveToSan(board, move);
-    pgn << san << " ";
-
-    board.makeMove(move);
-
-    if (board.sideToMove() == chess::Color::WHITE)
-      moveNumber++;
-  }
-
-  pgn << result;
-
-  return pgn.str();
-}
-std::string ConvertResultToPGN(const std::string& raw)
-{
-  if (raw.find("WHITE") != std::string::npos)
-    return "1-0";
-
-  if (raw.find("BLACK") != std::string::npos)
-    return "0-1";
-
-  if (raw.find("DRAW") != std::string::npos)
-    return "1/2-1/2";
-
-  return ""; // game still in progress
-}
 Texture *SvgStringToTexture(std::string svgString, SDL_Renderer *renderer, int size = 64) {
   Texture *tex = new Texture();
 
@@ -233,6 +253,11 @@ int main(int argc, char *argv[]) {
   (void)argc;
   (void)argv;
 
+  ChessSimulator::SetInfoCallback([](const ChessSimulator::MoveInfo &) {
+    if (stopRequested)
+      ChessSimulator::Stop();
+  });
+
   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) !=
       0) {
     printf("Error: %s\n", SDL_GetError());
@@ -295,6 +320,7 @@ int main(int argc, char *argv[]) {
 
   // Event loop
   while (!done) {
+    pollSearch(board);
     if (simulationState == SimulationState::RUNNING)
       move(board);
 
@@ -340,6 +366,12 @@ int main(int argc, char *argv[]) {
       simulationState = SimulationState::PAUSED;
       move(board);
     }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!searching());
+    if (ImGui::Button("Stop now")) {
+      stopSearch();
+    }
+    ImGui::EndDisabled();
     if (ImGui::Button("Export PGN"))    {
       std::string resultPGN = ConvertResultToPGN(gameResult);
       std::string pgn = GeneratePGN(movesUCI, resultPGN);
@@ -355,6 +387,14 @@ int main(int argc, char *argv[]) {
                 timeSpentLastMove.count() / 1000000.0);
 
     ImGui::Text("Game result: %s", gameResult.c_str());
+    ImGui::Separator();
+    if (searching()) {
+      ImGui::Text("Thinking...");
+      showSearchInfo(ChessSimulator::SearchProgress());
+    } else {
+      ImGui::Text("Last move: %s", lastMoveInfo.move.c_str());
+      showSearchInfo(lastMoveInfo);
+    }
     // moves
     ImGui::Separator();
     ImGui::BeginChild("Moves", ImVec2(0, 0), true);
@@ -462,6 +502,7 @@ int main(int argc, char *argv[]) {
   }
 
   // Cleanup
+  cancelSearch();
   ImGui_ImplSDLRenderer2_Shutdown();
   ImGui_ImplSDL2_Shutdown();
   ImGui::DestroyContext();
@@ -0,0 +1,73 @@
+#pragma once
+#include "chess.hpp"
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Shared by chessgui and chessmatch.
+
+using PGNHeaders = std::vector<std::pair<std::string, std::string>>;
+
+// startFen empty means the standard start position
+inline std::string GeneratePGN(const std::vector<std::string>& uciMoves,
+                               const std::string& result,
+                               const PGNHeaders& headers = {{"Event", "Self Play"}, {"Site", "Local"}},
+                               const std::string& startFen = "")
+{
+  chess::Board board = startFen.empty() ? chess::Board() : chess::Board(startFen);
+  std::ostringstream pgn;
+
+  // PGN headers
+  for (const auto& [name, value] : headers)
+    pgn << "[" << name << " \"" << value << "\"]\n";
+  pgn << "[Result \"" << result << "\"]\n";
+  if (!startFen.empty())
+  {
+    pgn << "[SetUp \"1\"]\n";
+    pgn << "[FEN \"" << startFen << "\"]\n";
+  }
+  pgn << "\n";
+
+  int moveNumber = board.fullMoveNumber();
+
+  for (size_t i = 0; i < uciMoves.size(); i++)
+  {
+    chess::Move move = chess::uci::uciToMove(board, uciMoves[i]);
+
+    if (board.sideToMove() == chess::Color::WHITE)
+    {
+      pgn << moveNumber << ". ";
+    }
+    else if (i == 0)
+    {
+      pgn << moveNumber << "... ";
+    }
+
+    std::string san = chess::uci::moveToSan(board, move);
+    pgn << san << " ";
+
+    board.makeMove(move);
+
+    if (board.sideToMove() == chess::Color::WHITE)
+      moveNumber++;
+  }
+
+  pgn << result;
+
+  return pgn.str();
+}
+
+inline std::string ConvertResultToPGN(const std::string& raw)
+{
+  if (raw.find("WHITE") != std::string::npos)
+    return "1-0";
+
+  if (raw.find("BLACK") != std::string::npos)
+    return "0-1";
+
+  if (raw.find("DRAW") != std::string::npos)
+    return "1/2-1/2";
+
+  return ""; // game still in progress
+}
@@ -0,0 +1,62 @@
+#include "elo.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double eloFromScore(double score) {
+    score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+double scoreFromElo(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+// mean and per-game variance of the score, counting a draw as half a point
+void scoreMoments(const MatchScore& score, double& mean, double& variance) {
+    double n = score.games();
+    mean = (score.wins + 0.5 * score.draws) / n;
+    variance = (score.wins * std::pow(1.0 - mean, 2) + score.draws * std::pow(0.5 - mean, 2) +
+                score.losses * std::pow(mean, 2)) / n;
+}
+
+} // namespace
+
+EloEstimate estimateElo(const MatchScore& score) {
+    EloEstimate estimate;
+    if (score.games() == 0)
+        return estimate;
+
+    double mean, variance;
+    scoreMoments(score, mean, variance);
+    double margin = 1.959964 * std::sqrt(variance / score.games());
+
+    estimate.elo = eloFromScore(mean);
+    estimate.error = (eloFromScore(mean + margin) - eloFromScore(mean - margin)) / 2.0;
+    if (score.wins + score.losses > 0)
+        estimate.los = 0.5 * (1.0 + std::erf((score.wins - score.losses) / std::sqrt(2.0 * (score.wins + score.losses))));
+    return estimate;
+}
+
+double Sprt::lowerBound() const {
+    return std::log(beta / (1.0 - alpha));
+}
+
+double Sprt::upperBound() const {
+    return std::log((1.0 - beta) / alpha);
+}
+
+double Sprt::llr(const MatchScore& score) const {
+    if (score.games() == 0)
+        return 0.0;
+
+    double mean, variance;
+    scoreMoments(score, mean, variance);
+    if (variance <= 0.0)
+        return 0.0;
+
+    double s0 = scoreFromElo(elo0);
+    double s1 = scoreFromElo(elo1);
+    return score.games() * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * variance);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * @brief Game outcomes from the first engine's point of view
+ */
+struct MatchScore {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const { return wins + draws + losses; }
+};
+
+/**
+ * @brief Logistic Elo difference with the half-width of its 95% confidence interval
+ */
+struct EloEstimate {
+    double elo = 0.0;
+    double error = 0.0;
+    /// Likelihood of superiority, the chance the first engine is really stronger
+    double los = 0.5;
+};
+
+EloEstimate estimateElo(const MatchScore& score);
+
+/**
+ * @brief Sequential probability ratio test of H0: elo = elo0 against H1: elo = elo1
+ */
+struct Sprt {
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+
+    double lowerBound() const;
+    double upperBound() const;
+    /// Log-likelihood ratio of the score so far, in the normal approximation
+    double llr(const MatchScore& score) const;
+};
@@ -0,0 +1,323 @@
+#include "chess-simulator.h"
+#include "chess.hpp"
+#include "elo.h"
+#include "pgn.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct EngineConfig {
+    std::string name;
+    ChessSimulator::Options options;
+};
+
+struct MatchSettings {
+    int games = 100;
+    int concurrency = int(std::max(1u, std::thread::hardware_concurrency()));
+    int moveTimeMs = 100;
+    int hashMb = 16;
+    int maxPlies = 400;
+    std::string openingsPath;
+    std::string pgnPath;
+    std::string syzygyPath;
+    bool useSprt = false;
+    Sprt sprt;
+    EngineConfig engines[2] = {{"A", {}}, {"B", {}}};
+};
+
+struct GameRecord {
+    int round = 0;
+    std::string startFen;
+    std::vector<std::string> moves;
+    bool firstIsWhite = true;
+    std::string result = "1/2-1/2";
+    std::string termination;
+};
+
+void printUsage() {
+    std::cerr << "usage: chessmatch [--games N] [--concurrency N] [--movetime MS] [--hash MB]\n"
+                 "                  [--max-plies N] [--openings FILE] [--pgn FILE] [--syzygy PATH]\n"
+                 "                  [--a SPEC] [--b SPEC] [--sprt ELO0,ELO1]\n"
+                 "SPEC is a comma-separated list of exact-mobility, no-null-move, no-lmr,\n"
+                 "no-futility and depth=N, e.g. --b no-lmr,depth=6\n";
+}
+
+bool parseEngineSpec(const std::string& spec, EngineConfig& config) {
+    std::istringstream in(spec);
+    std::string flag;
+    while (std::getline(in, flag, ',')) {
+        if (flag == "exact-mobility")
+            config.options.exactMobility = true;
+        else if (flag == "no-null-move")
+            config.options.nullMovePruning = false;
+        else if (flag == "no-lmr")
+            config.options.lateMoveReductions = false;
+        else if (flag == "no-futility")
+            config.options.futilityPruning = false;
+        else if (flag.rfind("depth=", 0) == 0)
+            config.options.maxDepth = std::stoi(flag.substr(6));
+        else if (!flag.empty())
+            return false;
+    }
+    if (!spec.empty())
+        config.name += " (" + spec + ")";
+    return true;
+}
+
+// One FEN or EPD per line; EPD lines get default move counters.
+std::vector<std::string> loadOpenings(const std::string& path) {
+    std::vector<std::string> openings;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::vector<std::string> fields;
+        std::string field;
+        while (fields.size() < 6 && in >> field)
+            fields.push_back(field);
+        if (fields.size() < 4 || fields[0][0] == '#')
+            continue;
+
+        bool counters = fields.size() == 6 && std::all_of(fields[4].begin(), fields[4].end(), ::isdigit) &&
+                        std::all_of(fields[5].begin(), fields[5].end(), ::isdigit);
+        std::string fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+        openings.push_back(fen + (counters ? " " + fields[4] + " " + fields[5] : " 0 1"));
+    }
+    return openings;
+}
+
+const char* terminationName(chess::GameResultReason reason) {
+    switch (reason) {
+    case chess::GameResultReason::CHECKMATE:
+        return "checkmate";
+    case chess::GameResultReason::STALEMATE:
+        return "stalemate";
+    case chess::GameResultReason::INSUFFICIENT_MATERIAL:
+        return "insufficient material";
+    case chess::GameResultReason::FIFTY_MOVE_RULE:
+        return "fifty-move rule";
+    case chess::GameResultReason::THREEFOLD_REPETITION:
+        return "threefold repetition";
+    default:
+        return "draw";
+    }
+}
+
+GameRecord playGame(ChessSimulator::Engine* engines[2], const std::string& startFen, bool firstIsWhite,
+                    const MatchSettings& settings) {
+    GameRecord game;
+    game.startFen = startFen;
+    game.firstIsWhite = firstIsWhite;
+
+    chess::Board board(startFen);
+    engines[0]->NewGame();
+    engines[1]->NewGame();
+
+    while (true) {
+        auto [reason, result] = board.isGameOver();
+        if (reason != chess::GameResultReason::NONE) {
+            if (result == chess::GameResult::LOSE)
+                game.result = board.sideToMove() == chess::Color::WHITE ? "0-1" : "1-0";
+            game.termination = terminationName(reason);
+            return game;
+        }
+        if (int(game.moves.size()) >= settings.maxPlies) {
+            game.termination = "adjudicated draw after " + std::to_string(settings.maxPlies) + " plies";
+            return game;
+        }
+
+        bool whiteToMove = board.sideToMove() == chess::Color::WHITE;
+        ChessSimulator::Engine* engine = engines[whiteToMove == firstIsWhite ? 0 : 1];
+        std::string uci = engine->Move(startFen, game.moves, settings.moveTimeMs);
+
+        chess::Movelist legal;
+        chess::movegen::legalmoves(legal, board);
+        chess::Move move = uci.empty() ? chess::Move(chess::Move::NO_MOVE) : chess::uci::uciToMove(board, uci);
+        if (std::find(legal.begin(), legal.end(), move) == legal.end()) {
+            game.result = whiteToMove ? "0-1" : "1-0";
+            game.termination = "illegal move " + (uci.empty() ? std::string("(none)") : uci);
+            return game;
+        }
+
+        board.makeMove(move);
+        game.moves.push_back(uci);
+    }
+}
+
+void addResult(MatchScore& score, const GameRecord& game) {
+    if (game.result == "1/2-1/2")
+        score.draws++;
+    else if ((game.result == "1-0") == game.firstIsWhite)
+        score.wins++;
+    else
+        score.losses++;
+}
+
+class Match {
+public:
+    Match(const MatchSettings& settings, std::vector<std::string> openings)
+        : settings(settings), openings(std::move(openings)) {}
+
+    int run();
+
+private:
+    const MatchSettings& settings;
+    std::vector<std::string> openings;
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> finished{false};
+
+    std::mutex resultMutex;
+    MatchScore score;
+    std::ofstream pgn;
+
+    void worker();
+    void report(const GameRecord& game);
+};
+
+void Match::worker() {
+    // every worker plays its games with its own pair of engines
+    ChessSimulator::Engine first(settings.hashMb), second(settings.hashMb);
+    first.SetOptions(settings.engines[0].options);
+    second.SetOptions(settings.engines[1].options);
+    ChessSimulator::Engine* engines[2] = {&first, &second};
+
+    while (!finished) {
+        int index = nextGame++;
+        if (index >= settings.games)
+            break;
+
+        // each opening is played twice with colours swapped
+        const std::string& opening = openings[(index / 2) % openings.size()];
+        GameRecord game = playGame(engines, opening, index % 2 == 0, settings);
+        game.round = index + 1;
+        report(game);
+    }
+}
+
+void Match::report(const GameRecord& game) {
+    std::lock_guard<std::mutex> lock(resultMutex);
+    addResult(score, game);
+
+    const std::string& white = settings.engines[game.firstIsWhite ? 0 : 1].name;
+    const std::string& black = settings.engines[game.firstIsWhite ? 1 : 0].name;
+    if (pgn.is_open()) {
+        PGNHeaders headers = {{"Event", "chessmatch"}, {"Site", "Local"}, {"Round", std::to_string(game.round)},
+                              {"White", white}, {"Black", black}, {"Termination", game.termination}};
+        pgn << GeneratePGN(game.moves, game.result, headers, game.startFen) << "\n\n";
+        pgn.flush();
+    }
+
+    EloEstimate elo = estimateElo(score);
+    std::printf("Game %d (%s vs %s): %s, %s | W %d D %d L %d | Elo %+.1f +/- %.1f, LOS %.1f%%", game.round,
+                white.c_str(), black.c_str(), game.result.c_str(), game.termination.c_str(), score.wins,
+                score.draws, score.losses, elo.elo, elo.error, elo.los * 100.0);
+    if (settings.useSprt) {
+        double llr = settings.sprt.llr(score);
+        std::printf(" | LLR %.2f (%.2f, %.2f)", llr, settings.sprt.lowerBound(), settings.sprt.upperBound());
+        if (llr <= settings.sprt.lowerBound() || llr >= settings.sprt.upperBound())
+            finished = true;
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+int Match::run() {
+    if (!settings.pgnPath.empty()) {
+        pgn.open(settings.pgnPath);
+        if (!pgn) {
+            std::cerr << "cannot write " << settings.pgnPath << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::min(settings.concurrency, settings.games); ++i)
+        workers.emplace_back([this] { worker(); });
+    for (auto& worker : workers)
+        worker.join();
+
+    EloEstimate elo = estimateElo(score);
+    std::printf("===========================\n");
+    std::printf("Games           : %d\n", score.games());
+    std::printf("Score of A vs B : %d - %d - %d\n", score.wins, score.losses, score.draws);
+    std::printf("Elo difference  : %+.1f +/- %.1f\n", elo.elo, elo.error);
+    std::printf("LOS             : %.1f%%\n", elo.los * 100.0);
+    if (settings.useSprt) {
+        double llr = settings.sprt.llr(score);
+        const char* verdict = llr >= settings.sprt.upperBound() ? "H1 accepted"
+                              : llr <= settings.sprt.lowerBound() ? "H0 accepted" : "inconclusive";
+        std::printf("SPRT            : elo0 %.1f elo1 %.1f, LLR %.2f (%.2f, %.2f), %s\n", settings.sprt.elo0,
+                    settings.sprt.elo1, llr, settings.sprt.lowerBound(), settings.sprt.upperBound(), verdict);
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    MatchSettings settings;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--games" && hasValue)
+            settings.games = std::stoi(argv[++i]);
+        else if (arg == "--concurrency" && hasValue)
+            settings.concurrency = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--movetime" && hasValue)
+            settings.moveTimeMs = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--hash" && hasValue)
+            settings.hashMb = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--max-plies" && hasValue)
+            settings.maxPlies = std::stoi(argv[++i]);
+        else if (arg == "--openings" && hasValue)
+            settings.openingsPath = argv[++i];
+        else if (arg == "--pgn" && hasValue)
+            settings.pgnPath = argv[++i];
+        else if (arg == "--syzygy" && hasValue)
+            settings.syzygyPath = argv[++i];
+        else if ((arg == "--a" || arg == "--b") && hasValue) {
+            if (!parseEngineSpec(argv[++i], settings.engines[arg == "--a" ? 0 : 1])) {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--sprt" && hasValue && std::sscanf(argv[++i], "%lf,%lf", &settings.sprt.elo0, &settings.sprt.elo1) == 2)
+            settings.useSprt = true;
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<std::string> openings;
+    if (!settings.openingsPath.empty()) {
+        openings = loadOpenings(settings.openingsPath);
+        if (openings.empty()) {
+            std::cerr << "no positions in " << settings.openingsPath << std::endl;
+            return 1;
+        }
+    } else {
+        std::cerr << "no --openings given, every game starts from the initial position" << std::endl;
+        openings.push_back(chess::constants::STARTPOS);
+    }
+
+    // the tablebases are shared by both engines of every game
+    if (!ChessSimulator::SetSyzygyPath(settings.syzygyPath)) {
+        std::cerr << "no tablebases in " << settings.syzygyPath << std::endl;
+        return 1;
+    }
+
+    Match match(settings, std::move(openings));
+    return match.run();
+}
@@ -1,5 +1,6 @@
 #include <emscripten/bind.h>
 #include "chess-simulator.h"
+#include <cstdio>
 #include <string>
 
 std::string safe_move(const std::string& fen, int timeLimitMs) {
@@ -11,6 +12,79 @@ std::string safe_move(const std::string& fen, int timeLimitMs) {
 #endif
 }
 
+std::string safe_move_threaded(const std::string& fen, int timeLimitMs, int threads) {
+#if defined(CHESS_HAS_TIME_LIMIT) && defined(CHESS_HAS_THREADS)
+    return ChessSimulator::Move(fen, timeLimitMs, threads);
+#else
+    (void)threads;
+    return safe_move(fen, timeLimitMs);
+#endif
+}
+
+static std::string json_string(const std::string& value) {
+    // UCI moves never need escaping
+    return "\"" + value + "\"";
+}
+
+// The search result as a JSON object; forks without MoveWithInfo() only report the move.
+std::string safe_move_info_json(const std::string& fen, int timeLimitMs, int threads) {
+#ifdef CHESS_HAS_MOVE_INFO
+    auto info = ChessSimulator::MoveWithInfo(fen, timeLimitMs, threads);
+    const auto& stats = info.stats;
+
+    std::string pv;
+    for (const auto& move : info.pv)
+        pv += (pv.empty() ? "" : ",") + json_string(move);
+
+    std::string iterations;
+    for (const auto& iteration : stats.iterations) {
+        char buffer[160];
+        std::snprintf(buffer, sizeof(buffer),
+                      "{\"depth\":%d,\"score\":%d,\"nodes\":%llu,\"timeMs\":%lld,\"branchingFactor\":%.3f}",
+                      iteration.depth, iteration.score, (unsigned long long)iteration.nodes,
+                      (long long)iteration.timeMs, iteration.branchingFactor);
+        iterations += (iterations.empty() ? "" : ",") + std::string(buffer);
+    }
+
+    char counters[400];
+    std::snprintf(counters, sizeof(counters),
+                  "\"nodes\":%llu,\"qnodes\":%llu,\"ttProbes\":%llu,\"ttHits\":%llu,\"ttCutoffs\":%llu,"
+                  "\"failHighFirst\":%llu,\"failHighLater\":%llu,\"tbHits\":%llu,\"depth\":%d,\"timeMs\":%lld",
+                  (unsigned long long)stats.nodes, (unsigned long long)stats.qnodes,
+                  (unsigned long long)stats.ttProbes, (unsigned long long)stats.ttHits,
+                  (unsigned long long)stats.ttCutoffs, (unsigned long long)stats.failHighFirst,
+                  (unsigned long long)stats.failHighLater, (unsigned long long)stats.tbHits, stats.depth,
+                  (long long)stats.timeMs);
+
+    return "{\"move\":" + json_string(info.move) +
+           ",\"score\":" + std::to_string(info.score) +
+           ",\"mate\":" + std::to_string(info.mate) +
+           ",\"pv\":[" + pv + "]" +
+           ",\"bookMove\":" + (info.bookMove ? "true" : "false") +
+           ",\"stats\":{" + counters + ",\"iterations\":[" + iterations + "]}}";
+#else
+    return "{\"move\":" + json_string(safe_move_threaded(fen, timeLimitMs, threads)) + "}";
+#endif
+}
+
+// Loads a Polyglot book from the module's file system, e.g. one written with FS.writeFile().
+bool safe_set_book(const std::string& path) {
+#ifdef CHESS_HAS_BOOK
+    return ChessSimulator::SetBook(path);
+#else
+    (void)path;
+    return false;
+#endif
+}
+
 EMSCRIPTEN_BINDINGS(chess_module) {
+#if defined(CHESS_HAS_BOOK) && defined(CHESS_WASM_BOOK)
+    // the book embedded at link time
+    ChessSimulator::SetBook(CHESS_WASM_BOOK);
+#endif
+
     emscripten::function("move", &safe_move);
+    emscripten::function("moveThreaded", &safe_move_threaded);
+    emscripten::function("moveInfo", &safe_move_info_json);
+    emscripten::function("setBook", &safe_set_book);
 }
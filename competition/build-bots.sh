@@ -12,6 +12,7 @@ REPO_OWNER="gameguild-gg"
 REPO_NAME="chess-competition"
 API_URL="https://api.github.com/repos/${REPO_OWNER}/${REPO_NAME}/forks"
 TIME_LIMIT_MS=10000
+THREAD_POOL_SIZE=4
 
 # ---------- Colors ----------
 RED='\033[0;31m'
@@ -111,6 +112,24 @@ compile_fork() {
         log "  Note: fork does not have timeLimitMs parameter"
     fi
 
+    # Detect whether the fork's Move() accepts a thread count; only those get a threaded build
+    local has_threads="ON"
+    if ! grep -q "int threads" "${fork_dir}/chess-bot/chess-simulator.h"; then
+        has_threads="OFF"
+    fi
+
+    # Detect whether the fork has MoveWithInfo(); without it moveInfo() only reports the move
+    local has_move_info="ON"
+    if ! grep -q "MoveWithInfo" "${fork_dir}/chess-bot/chess-simulator.h"; then
+        has_move_info="OFF"
+    fi
+
+    # Detect whether the fork has SetBook(); without it setBook() does nothing
+    local has_book="ON"
+    if ! grep -q "SetBook" "${fork_dir}/chess-bot/chess-simulator.h"; then
+        has_book="OFF"
+    fi
+
     # Configure
     rm -rf "$build_dir"
     mkdir -p "$build_dir"
@@ -122,6 +141,11 @@ compile_fork() {
         -DCMAKE_BUILD_TYPE=Release \
         -DCHESS_COMPETITION=ON \
         -DCHESS_HAS_TIME_LIMIT="${has_time_limit}" \
+        -DCHESS_HAS_THREADS="${has_threads}" \
+        -DCHESS_HAS_MOVE_INFO="${has_move_info}" \
+        -DCHESS_HAS_BOOK="${has_book}" \
+        -DCHESS_WASM_THREADS="${has_threads}" \
+        -DCHESS_WASM_THREAD_POOL_SIZE="${THREAD_POOL_SIZE}" \
         -DCHESS_BOT_NAME="${username}" \
         2>&1 | tail -5; then
         err "  CMake configure failed for '${username}'"
@@ -135,6 +159,23 @@ compile_fork() {
         return 1
     fi
 
+    # Threaded variant is optional: a failure here only loses the fast path
+    rm -f "${BOTS_OUTPUT_DIR}/${username}-mt.js" "${BOTS_OUTPUT_DIR}/${username}-mt.wasm"
+    if [ "$has_threads" = "ON" ]; then
+        log "  Building threaded variant..."
+        if cmake --build "$build_dir" --target "${username}-mt" --parallel 2>&1 | tail -5 && \
+           [ -f "${build_dir}/${username}-mt.js" ] && [ -f "${build_dir}/${username}-mt.wasm" ]; then
+            cp "${build_dir}/${username}-mt.js" "${BOTS_OUTPUT_DIR}/"
+            cp "${build_dir}/${username}-mt.wasm" "${BOTS_OUTPUT_DIR}/"
+            # older Emscripten versions emit a separate pthread worker script
+            if [ -f "${build_dir}/${username}-mt.worker.js" ]; then
+                cp "${build_dir}/${username}-mt.worker.js" "${BOTS_OUTPUT_DIR}/"
+            fi
+        else
+            warn "  Threaded build failed for '${username}', using single-threaded module only"
+        fi
+    fi
+
     # Copy outputs
     if [ -f "${build_dir}/${username}.js" ] && [ -f "${build_dir}/${username}.wasm" ]; then
         cp "${build_dir}/${username}.js" "${BOTS_OUTPUT_DIR}/"
@@ -197,7 +238,11 @@ main() {
         log "=== [$(( i + 1 ))/${total}] ${username} ==="
 
         if compile_fork "$username" "$clone_url"; then
-            python3 "${SCRIPTS_DIR}/manifest.py" add "$manifest_tmp" "$username" "$avatar_url" "$html_url"
+            local threaded="false"
+            if [ -f "${BOTS_OUTPUT_DIR}/${username}-mt.js" ]; then
+                threaded="true"
+            fi
+            python3 "${SCRIPTS_DIR}/manifest.py" add "$manifest_tmp" "$username" "$avatar_url" "$html_url" "$threaded"
             success_count=$((success_count + 1))
         else
             warn "Skipping '${username}' due to errors"
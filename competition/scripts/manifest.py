@@ -2,7 +2,7 @@
 """Manage the competition manifest.json file.
 
 Usage:
-    manifest.py add <manifest_file> <username> <avatar_url> <fork_url>
+    manifest.py add <manifest_file> <username> <avatar_url> <fork_url> [threaded]
     manifest.py format <manifest_file> <output_file>
 """
 
@@ -10,16 +10,20 @@ import json
 import sys
 
 
-def add_entry(manifest_file: str, username: str, avatar: str, fork_url: str) -> None:
+def add_entry(manifest_file: str, username: str, avatar: str, fork_url: str,
+              threaded: bool = False) -> None:
     """Append a bot entry to the manifest."""
     with open(manifest_file) as f:
         manifest = json.load(f)
 
-    manifest.append({
+    entry = {
         "username": username,
         "avatar": avatar,
         "forkUrl": fork_url,
-    })
+    }
+    if threaded:
+        entry["threaded"] = True
+    manifest.append(entry)
 
     with open(manifest_file, "w") as f:
         json.dump(manifest, f)
@@ -42,11 +46,12 @@ def main() -> None:
     command = sys.argv[1]
 
     if command == "add":
-        if len(sys.argv) != 6:
-            print(f"Usage: {sys.argv[0]} add <manifest_file> <username> <avatar_url> <fork_url>",
+        if len(sys.argv) not in (6, 7):
+            print(f"Usage: {sys.argv[0]} add <manifest_file> <username> <avatar_url> <fork_url> [threaded]",
                   file=sys.stderr)
             sys.exit(1)
-        add_entry(sys.argv[2], sys.argv[3], sys.argv[4], sys.argv[5])
+        threaded = len(sys.argv) == 7 and sys.argv[6] == "true"
+        add_entry(sys.argv[2], sys.argv[3], sys.argv[4], sys.argv[5], threaded)
 
     elif command == "format":
         if len(sys.argv) != 4:
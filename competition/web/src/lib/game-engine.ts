@@ -12,6 +12,9 @@ import type {
 const INITIAL_FEN = 'rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1';
 const DEFAULT_TIME_LIMIT_MS = 10000;
 const DEFAULT_MOVE_DELAY_MS = 500;
+// Matches CHESS_WASM_THREAD_POOL_SIZE in build-bots.sh, plus the calling thread
+const MAX_BOT_THREADS = 5;
+const BOT_THREADS = Math.max(1, Math.min(MAX_BOT_THREADS, navigator.hardwareConcurrency ?? 1));
 
 export class GameEngine {
   private chess: Chess;
@@ -109,6 +112,9 @@ export class GameEngine {
       const whiteMsg: WorkerInMessage = {
         type: 'load',
         botUrl: `${base}bots/${whitePlayer.bot.username}.js`,
+        threadedBotUrl: whitePlayer.bot.threaded
+          ? `${base}bots/${whitePlayer.bot.username}-mt.js`
+          : undefined,
       };
       this.whiteWorker.postMessage(whiteMsg);
       loadPromises.push(whiteReady);
@@ -124,6 +130,9 @@ export class GameEngine {
       const blackMsg: WorkerInMessage = {
         type: 'load',
         botUrl: `${base}bots/${blackPlayer.bot.username}.js`,
+        threadedBotUrl: blackPlayer.bot.threaded
+          ? `${base}bots/${blackPlayer.bot.username}-mt.js`
+          : undefined,
       };
       this.blackWorker.postMessage(blackMsg);
       loadPromises.push(blackReady);
@@ -419,6 +428,7 @@ export class GameEngine {
         type: 'move',
         fen,
         timeLimitMs: this.timeLimitMs,
+        threads: BOT_THREADS,
       };
       worker.postMessage(msg);
     });
@@ -2,6 +2,7 @@ export interface BotInfo {
   username: string;
   avatar: string;
   forkUrl: string;
+  threaded?: boolean; // a <username>-mt.js pthreads build is available
 }
 
 export type PlayerType = 'bot' | 'human';
@@ -88,8 +89,8 @@ export interface TournamentState {
 
 // Messages from main thread -> worker
 export type WorkerInMessage =
-  | { type: 'load'; botUrl: string }
-  | { type: 'move'; fen: string; timeLimitMs: number };
+  | { type: 'load'; botUrl: string; threadedBotUrl?: string }
+  | { type: 'move'; fen: string; timeLimitMs: number; threads: number };
 
 // Messages from worker -> main thread
 export type WorkerOutMessage =
@@ -5,22 +5,45 @@ import type { WorkerInMessage, WorkerOutMessage } from '../lib/types';
 
 interface ChessBotModule {
   move(fen: string, timeLimitMs: number): string;
+  moveThreaded?(fen: string, timeLimitMs: number, threads: number): string;
 }
 
 let bot: ChessBotModule | null = null;
+let threaded = false;
+
+async function loadModule(url: string): Promise<ChessBotModule> {
+  // Dynamically import the Emscripten ES6 module
+  // The URL points to e.g. /bots/alice.js which co-locates with alice.wasm
+  const module = await import(/* @vite-ignore */ url);
+
+  // Emscripten ES6 modules export a default factory function
+  const factory = module.default;
+  return await factory();
+}
 
 self.onmessage = async (e: MessageEvent<WorkerInMessage>) => {
   const msg = e.data;
 
   if (msg.type === 'load') {
     try {
-      // Dynamically import the Emscripten ES6 module
-      // The URL points to e.g. /bots/alice.js which co-locates with alice.wasm
-      const module = await import(/* @vite-ignore */ msg.botUrl);
+      bot = null;
+      threaded = false;
+
+      // The pthreads build needs SharedArrayBuffer, which browsers only expose
+      // on cross-origin isolated pages; otherwise use the single-threaded module.
+      if (msg.threadedBotUrl && self.crossOriginIsolated) {
+        try {
+          bot = await loadModule(msg.threadedBotUrl);
+          threaded = typeof bot.moveThreaded === 'function';
+        } catch {
+          bot = null;
+        }
+      }
 
-      // Emscripten ES6 modules export a default factory function
-      const factory = module.default;
-      bot = await factory();
+      if (!bot || !threaded) {
+        bot = await loadModule(msg.botUrl);
+        threaded = false;
+      }
 
       const reply: WorkerOutMessage = { type: 'ready' };
       self.postMessage(reply);
@@ -37,7 +60,9 @@ self.onmessage = async (e: MessageEvent<WorkerInMessage>) => {
     }
 
     try {
-      const uci = bot.move(msg.fen, msg.timeLimitMs);
+      const uci = threaded && bot.moveThreaded
+        ? bot.moveThreaded(msg.fen, msg.timeLimitMs, msg.threads)
+        : bot.move(msg.fen, msg.timeLimitMs);
       const reply: WorkerOutMessage = { type: 'result', uci };
       self.postMessage(reply);
     } catch (err: unknown) {